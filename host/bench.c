@@ -0,0 +1,161 @@
+/* bench.c
+
+   Host micro-benchmarks for the portable lab code, built from the
+   time4int sources against the in-memory hardware (dtekv-host.h).
+
+     make -C host run            # or: make -C host LAB=../suprise run
+
+   Each line is the mean time per call over many calls. A few results
+   are checked along the way, so an algorithmic change that breaks
+   them fails here before it reaches the board. */
+
+#include <stdio.h>
+#include <string.h>
+#include "clock.h"
+#include "console.h"
+#include "display.h"
+#include "dtekv-host.h"
+#include "dtekv-lib.h"
+#include "fixed.h"
+
+static volatile unsigned sink;          /* Keeps results alive. */
+static int failed;
+
+static void report(const char *name, unsigned long long ns, unsigned n)
+{
+  printf("BENCH %-14s %10u calls %10.2f ns/call\n", name, n, (double) ns / n);
+}
+
+static void check(int ok, const char *what)
+{
+  if (!ok) {
+    printf("CHECK failed: %s\n", what);
+    failed = 1;
+  }
+}
+
+static void run_nextprime(void)
+{
+  const unsigned n = 200000;
+  unsigned long long t0 = host_cycles();
+  int p = 1234567;
+  unsigned i;
+
+  for (i = 0; i < n; i++)
+    p = nextprime(p);
+  report("nextprime", host_cycles() - t0, n);
+  check(nextprime(1234567) == 1234577, "nextprime(1234567) == 1234577");
+  check(nextprime(2147483600) == 2147483629, "nextprime(2147483600)");
+  sink = p;
+}
+
+static void run_print_dec(void)
+{
+  const unsigned n = 1000000;
+  unsigned long long t0;
+  unsigned i;
+
+  print_dec(4294967295u);
+  check(host_uart_len == 10 && memcmp(host_uart, "4294967295", 10) == 0,
+        "print_dec(4294967295) reaches the UART");
+  t0 = host_cycles();
+  for (i = 0; i < n; i++)
+    print_dec(i * 2654435761u);
+  report("print_dec", host_cycles() - t0, n);
+  host_reset();
+}
+
+static void run_tick(void)
+{
+  const unsigned n = 10000000;
+  unsigned long long t0;
+  unsigned i;
+  int t = 0;
+
+  for (i = 0; i < 3600; i++)
+    clock_tick(&t);
+  check(t == 0x10000, "3600 ticks from 00:00 carry into bit 16");
+  t = 0x5957;
+  clock_tick(&t);
+  check(t == 0x5958, "tick(59:57) == 59:58");
+
+  t = 0;
+  t0 = host_cycles();
+  for (i = 0; i < n; i++)
+    clock_tick(&t);
+  report("tick", host_cycles() - t0, n);
+  sink = t;
+}
+
+static void run_time2string(void)
+{
+  const unsigned n = 10000000;
+  unsigned long long t0;
+  char buf[8];
+  unsigned i;
+
+  clock_time2string(buf, 0x5957);
+  check(strcmp(buf, "59:57") == 0, "time2string(0x5957) == \"59:57\"");
+  t0 = host_cycles();
+  for (i = 0; i < n; i++)
+    clock_time2string(buf, i);
+  report("time2string", host_cycles() - t0, n);
+  sink = buf[4];
+}
+
+static void run_fixed(void)
+{
+  const unsigned n = 10000000;
+  unsigned long long t0;
+  char buf[20];
+  unsigned i;
+  fix16_t x = 0;
+
+  fix16_fmt(buf, fix16_sqrt(fix16_from_int(2)), 4);
+  check(strcmp(buf, "1.4142") == 0, "fix16_sqrt(2) == 1.4142");
+  check(fix16_div(fix16_from_int(1), fix16_from_int(3)) == 21845, "1 / 3 == 0x5555");
+  check(fix16_mul(FIX16_MAX, fix16_from_int(2)) == FIX16_MAX, "mul saturates");
+
+  t0 = host_cycles();
+  for (i = 0; i < n; i++)
+    x += fix16_div(i | 1, 0x00012345);
+  report("fix16_div", host_cycles() - t0, n);
+  t0 = host_cycles();
+  for (i = 0; i < n; i++)
+    x += fix16_sqrt(i);
+  report("fix16_sqrt", host_cycles() - t0, n);
+  sink = x;
+}
+
+/* A day of clock seconds through the display shadow: the MMIO log
+   shows how many register writes that costs. */
+static void run_display_day(void)
+{
+  const unsigned n = 86400;
+  int h = 0, m = 0, s = 0;
+  unsigned long long t0;
+  unsigned i;
+
+  host_reset();
+  t0 = host_cycles();
+  for (i = 0; i < n; i++) {
+    clock_add_seconds(&h, &m, &s, 1);
+    display_clock(h, m, s);
+    display_flush();
+  }
+  report("display_second", host_cycles() - t0, n);
+  printf("MMIO  %u HEX writes for %u seconds\n", host_log_count, n);
+  check(h == 0 && m == 0 && s == 0, "a day of seconds wraps to 00:00:00");
+  check(host_log_count < 2 * n, "display_flush writes changed digits only");
+}
+
+int main(void)
+{
+  run_nextprime();
+  run_print_dec();
+  run_tick();
+  run_time2string();
+  run_fixed();
+  run_display_day();
+  return failed;
+}
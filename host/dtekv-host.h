@@ -0,0 +1,43 @@
+/* dtekv-host.h
+
+   Host backend of the hardware shim. Building the lab sources with
+   -DDTEKV_HOST makes dtekv-hw.h, dtekv-csr.h and trap.h pull this in
+   instead of touching the board:
+
+   - Every device register lives in host_mmio[], which mirrors the
+     0x04000000 device window word for word.
+   - HW_WRITE goes through host_write(), which applies the register's
+     side effect (edge_capture clears, the JTAG UART data register
+     appends to host_uart) and records the write in host_log.
+   - mcycle and minstret read host_cycles(), monotonic nanoseconds.
+   - mstatus.MIE and mie are plain variables. */
+
+#ifndef DTEKV_HOST_H
+#define DTEKV_HOST_H
+
+#define HOST_MMIO_WORDS 64              /* 0x04000000..0x040000ff */
+#define HOST_LOG_SIZE   4096            /* Writes kept; older ones dropped. */
+#define HOST_UART_SIZE  4096
+
+struct host_write {
+  unsigned addr;                        /* Board address of the register. */
+  unsigned val;
+};
+
+extern volatile unsigned host_mmio[HOST_MMIO_WORDS];
+extern unsigned host_mstatus, host_mie;
+
+extern struct host_write host_log[HOST_LOG_SIZE];
+extern unsigned host_log_count;         /* Total writes, including dropped. */
+
+extern char host_uart[HOST_UART_SIZE];
+extern unsigned host_uart_len;          /* Total bytes, wraps the buffer. */
+
+void host_write(volatile unsigned *reg, unsigned val);
+void host_reset(void);                  /* Clear the log and the UART. */
+unsigned long long host_cycles(void);
+
+#define HW_WRITE(reg, val) host_write(&(reg), (val))
+#define HW_READ(reg)       (reg)
+
+#endif
@@ -0,0 +1,60 @@
+/* mmio.c
+
+   The host device window. Only the side effects the lab code depends
+   on are modelled; everything else is plain memory. */
+
+#include <time.h>
+#include "dtekv-host.h"
+
+#define OFF_SWITCHES_EDGE  0x1c
+#define OFF_JTAG_DATA      0x40
+#define OFF_JTAG_CONTROL   0x44
+#define OFF_BUTTONS_EDGE   0xdc
+
+/* The UART always reports a full FIFO's worth of space. */
+volatile unsigned host_mmio[HOST_MMIO_WORDS] = {
+  [OFF_JTAG_CONTROL / 4] = 0xffffu << 16,
+};
+unsigned host_mstatus = 8;
+unsigned host_mie;
+
+struct host_write host_log[HOST_LOG_SIZE];
+unsigned host_log_count;
+
+char host_uart[HOST_UART_SIZE];
+unsigned host_uart_len;
+
+void host_write(volatile unsigned *reg, unsigned val)
+{
+  unsigned off = (unsigned) (reg - host_mmio) * 4;
+  struct host_write *w = &host_log[host_log_count++ % HOST_LOG_SIZE];
+
+  w->addr = 0x04000000 + off;
+  w->val = val;
+  switch (off) {
+  case OFF_SWITCHES_EDGE:
+  case OFF_BUTTONS_EDGE:
+    *reg = 0;
+    break;
+  case OFF_JTAG_DATA:
+    host_uart[host_uart_len++ % HOST_UART_SIZE] = val;
+    break;
+  default:
+    *reg = val;
+    break;
+  }
+}
+
+void host_reset(void)
+{
+  host_log_count = 0;
+  host_uart_len = 0;
+}
+
+unsigned long long host_cycles(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
@@ -0,0 +1,362 @@
+/* cpu.c
+
+   RV32IM + Zicsr interpreter with machine-mode traps, mret and wfi. */
+
+#include <string.h>
+#include "sim.h"
+
+#define MSTATUS_MIE   0x00000008u
+#define MSTATUS_MPIE  0x00000080u
+#define MSTATUS_MPP   0x00001800u
+
+#define CAUSE_ILLEGAL     2
+#define CAUSE_BREAKPOINT  3
+#define CAUSE_LOAD_FAULT  5
+#define CAUSE_STORE_FAULT 7
+#define CAUSE_ECALL_M     11
+
+void cpu_reset(struct cpu *c, uint32_t entry)
+{
+  memset(c, 0, sizeof(*c));
+  c->pc = entry;
+  c->mstatus = MSTATUS_MPP;
+}
+
+static void trap(struct cpu *c, uint32_t cause, int irq, uint32_t tval)
+{
+  c->mepc = c->pc;
+  c->mcause = cause | (irq ? 0x80000000u : 0);
+  c->mtval = tval;
+  c->mstatus = (c->mstatus & ~(MSTATUS_MIE | MSTATUS_MPIE))
+             | ((c->mstatus & MSTATUS_MIE) ? MSTATUS_MPIE : 0)
+             | MSTATUS_MPP;
+  if (irq && (c->mtvec & 3) == 1)
+    c->pc = (c->mtvec & ~3u) + 4 * cause;
+  else
+    c->pc = c->mtvec & ~3u;
+  if (irq)
+    c->irqs[cause & 31]++;
+  else
+    c->traps[cause & 31]++;
+}
+
+static int mem_ok(uint32_t addr, uint32_t size)
+{
+  return addr + size <= RAM_SIZE && addr + size >= addr;
+}
+
+static int is_mmio(uint32_t addr)
+{
+  return addr >= MMIO_BASE && addr < MMIO_BASE + MMIO_SIZE;
+}
+
+static int load(struct cpu *c, struct board *b, uint32_t addr, int size,
+                uint32_t *v)
+{
+  if (is_mmio(addr)) {
+    uint32_t w = mmio_read(b, c, (addr - MMIO_BASE) & ~3u);
+    *v = w >> (8 * (addr & 3));
+    return 1;
+  }
+  if (!mem_ok(addr, size))
+    return 0;
+  switch (size) {
+  case 1: *v = ram[addr]; break;
+  case 2: *v = ram[addr] | ram[addr + 1] << 8; break;
+  default:
+    *v = ram[addr] | ram[addr + 1] << 8 | ram[addr + 2] << 16
+       | (uint32_t) ram[addr + 3] << 24;
+    break;
+  }
+  return 1;
+}
+
+static int store(struct cpu *c, struct board *b, uint32_t addr, int size,
+                 uint32_t v)
+{
+  if (is_mmio(addr)) {
+    mmio_write(b, c, (addr - MMIO_BASE) & ~3u, v);
+    return 1;
+  }
+  if (!mem_ok(addr, size))
+    return 0;
+  ram[addr] = v;
+  if (size >= 2)
+    ram[addr + 1] = v >> 8;
+  if (size == 4) {
+    ram[addr + 2] = v >> 16;
+    ram[addr + 3] = v >> 24;
+  }
+  return 1;
+}
+
+static int csr_read(struct cpu *c, struct board *b, uint32_t csr, uint32_t *v)
+{
+  switch (csr) {
+  case 0x300: *v = c->mstatus; break;
+  case 0x301: *v = 0x40001100u; break;        /* RV32 I M */
+  case 0x304: *v = c->mie; break;
+  case 0x305: *v = c->mtvec; break;
+  case 0x340: *v = c->mscratch; break;
+  case 0x341: *v = c->mepc; break;
+  case 0x342: *v = c->mcause; break;
+  case 0x343: *v = c->mtval; break;
+  case 0x344: *v = board_pending(b); break;
+  case 0xb00: case 0xc00: case 0xc01: *v = (uint32_t) c->cycle; break;
+  case 0xb80: case 0xc80: case 0xc81: *v = (uint32_t) (c->cycle >> 32); break;
+  case 0xb02: case 0xc02: *v = (uint32_t) c->instret; break;
+  case 0xb82: case 0xc82: *v = (uint32_t) (c->instret >> 32); break;
+  case 0xf11: case 0xf12: case 0xf13: case 0xf14: *v = 0; break;
+  default: return 0;
+  }
+  return 1;
+}
+
+static int csr_write(struct cpu *c, uint32_t csr, uint32_t v)
+{
+  switch (csr) {
+  case 0x300: c->mstatus = (v & (MSTATUS_MIE | MSTATUS_MPIE)) | MSTATUS_MPP; break;
+  case 0x301: break;
+  case 0x304: c->mie = v; break;
+  case 0x305: c->mtvec = v; break;
+  case 0x340: c->mscratch = v; break;
+  case 0x341: c->mepc = v & ~1u; break;
+  case 0x342: c->mcause = v; break;
+  case 0x343: c->mtval = v; break;
+  case 0x344: break;                          /* Device lines are read-only. */
+  case 0xb00: c->cycle = (c->cycle & ~0xffffffffull) | v; break;
+  case 0xb80: c->cycle = (c->cycle & 0xffffffffull) | (uint64_t) v << 32; break;
+  case 0xb02: c->instret = (c->instret & ~0xffffffffull) | v; break;
+  case 0xb82: c->instret = (c->instret & 0xffffffffull) | (uint64_t) v << 32; break;
+  default: return 0;
+  }
+  return 1;
+}
+
+static uint32_t mulhu32(uint32_t a, uint32_t b)
+{
+  return (uint32_t) (((uint64_t) a * b) >> 32);
+}
+
+/* Execute one instruction, or take one interrupt. Returns its cost. */
+unsigned cpu_step(struct cpu *c, struct board *b)
+{
+  uint32_t pending = board_pending(b) & c->mie;
+  uint32_t insn, next, rd, rs1v, rs2v, op, f3, f7;
+  int32_t imm;
+  unsigned cost = CYC_ALU;
+
+  if (pending != 0) {
+    c->waiting = 0;
+    if (c->mstatus & MSTATUS_MIE) {
+      uint32_t cause = 0;
+      while (!(pending & (1u << cause)))
+        cause++;                              /* Lowest line first. */
+      trap(c, cause, 1, 0);
+      return CYC_TRAP;
+    }
+  }
+  if (c->waiting)
+    return 0;
+
+  if (!load(c, b, c->pc, 4, &insn) || (c->pc & 3)) {
+    trap(c, 1, 0, c->pc);
+    return CYC_TRAP;
+  }
+  next = c->pc + 4;
+  op = insn & 0x7f;
+  rd = (insn >> 7) & 31;
+  f3 = (insn >> 12) & 7;
+  f7 = insn >> 25;
+  rs1v = c->x[(insn >> 15) & 31];
+  rs2v = c->x[(insn >> 20) & 31];
+
+  switch (op) {
+  case 0x37:                                  /* lui */
+    if (rd) c->x[rd] = insn & 0xfffff000u;
+    break;
+  case 0x17:                                  /* auipc */
+    if (rd) c->x[rd] = c->pc + (insn & 0xfffff000u);
+    break;
+  case 0x6f:                                  /* jal */
+    imm = ((int32_t) (insn & 0x80000000u) >> 11) | (insn & 0xff000)
+        | ((insn >> 9) & 0x800) | ((insn >> 20) & 0x7fe);
+    if (rd) c->x[rd] = next;
+    if (imm == 0 && rd == 0 && !((c->mstatus & MSTATUS_MIE) && c->mie)) {
+      c->halted = 1;
+      c->halt_reason = "idle loop with interrupts off";
+    }
+    next = c->pc + imm;
+    cost = CYC_TAKEN;
+    break;
+  case 0x67:                                  /* jalr */
+    imm = (int32_t) insn >> 20;
+    next = (rs1v + imm) & ~1u;
+    if (rd) c->x[rd] = c->pc + 4;
+    cost = CYC_TAKEN;
+    break;
+  case 0x63: {                                /* branches */
+    int taken;
+    imm = ((int32_t) (insn & 0x80000000u) >> 19) | ((insn << 4) & 0x800)
+        | ((insn >> 20) & 0x7e0) | ((insn >> 7) & 0x1e);
+    switch (f3) {
+    case 0: taken = rs1v == rs2v; break;
+    case 1: taken = rs1v != rs2v; break;
+    case 4: taken = (int32_t) rs1v < (int32_t) rs2v; break;
+    case 5: taken = (int32_t) rs1v >= (int32_t) rs2v; break;
+    case 6: taken = rs1v < rs2v; break;
+    case 7: taken = rs1v >= rs2v; break;
+    default: trap(c, CAUSE_ILLEGAL, 0, insn); return CYC_TRAP;
+    }
+    if (taken) {
+      next = c->pc + imm;
+      cost = CYC_TAKEN;
+    } else {
+      cost = CYC_BRANCH;
+    }
+    break;
+  }
+  case 0x03: {                                /* loads */
+    uint32_t v, addr = rs1v + ((int32_t) insn >> 20);
+    int size = 1 << (f3 & 3);
+    if (f3 == 3 || f3 > 5) {
+      trap(c, CAUSE_ILLEGAL, 0, insn);
+      return CYC_TRAP;
+    }
+    if (!load(c, b, addr, size, &v)) {
+      trap(c, CAUSE_LOAD_FAULT, 0, addr);
+      return CYC_TRAP;
+    }
+    if (f3 == 0) v = (int32_t) (int8_t) v;
+    else if (f3 == 1) v = (int32_t) (int16_t) v;
+    else if (f3 == 4) v &= 0xff;
+    else if (f3 == 5) v &= 0xffff;
+    if (rd) c->x[rd] = v;
+    cost = CYC_LOAD;
+    break;
+  }
+  case 0x23: {                                /* stores */
+    uint32_t addr = rs1v + (((int32_t) insn >> 20 & ~31) | rd);
+    if (f3 > 2) {
+      trap(c, CAUSE_ILLEGAL, 0, insn);
+      return CYC_TRAP;
+    }
+    if (!store(c, b, addr, 1 << f3, rs2v)) {
+      trap(c, CAUSE_STORE_FAULT, 0, addr);
+      return CYC_TRAP;
+    }
+    cost = CYC_STORE;
+    break;
+  }
+  case 0x13: {                                /* op-imm */
+    uint32_t v;
+    imm = (int32_t) insn >> 20;
+    switch (f3) {
+    case 0: v = rs1v + imm; break;
+    case 1: v = rs1v << (imm & 31); break;
+    case 2: v = (int32_t) rs1v < imm; break;
+    case 3: v = rs1v < (uint32_t) imm; break;
+    case 4: v = rs1v ^ imm; break;
+    case 5: v = (insn & 0x40000000u) ? (uint32_t) ((int32_t) rs1v >> (imm & 31))
+                                     : rs1v >> (imm & 31); break;
+    case 6: v = rs1v | imm; break;
+    default: v = rs1v & imm; break;
+    }
+    if (rd) c->x[rd] = v;
+    break;
+  }
+  case 0x33: {                                /* op */
+    uint32_t v;
+    if (f7 == 1) {
+      int32_t a = rs1v, d = rs2v;
+      cost = f3 < 4 ? CYC_MUL : CYC_DIV;
+      switch (f3) {
+      case 0: v = rs1v * rs2v; break;
+      case 1: v = (uint32_t) (((int64_t) a * d) >> 32); break;
+      case 2: v = (uint32_t) (((int64_t) a * (uint64_t) rs2v) >> 32); break;
+      case 3: v = mulhu32(rs1v, rs2v); break;
+      case 4: v = d == 0 ? ~0u : (a == INT32_MIN && d == -1) ? rs1v : (uint32_t) (a / d); break;
+      case 5: v = rs2v == 0 ? ~0u : rs1v / rs2v; break;
+      case 6: v = d == 0 ? rs1v : (a == INT32_MIN && d == -1) ? 0 : (uint32_t) (a % d); break;
+      default: v = rs2v == 0 ? rs1v : rs1v % rs2v; break;
+      }
+    } else {
+      switch (f3) {
+      case 0: v = f7 == 0x20 ? rs1v - rs2v : rs1v + rs2v; break;
+      case 1: v = rs1v << (rs2v & 31); break;
+      case 2: v = (int32_t) rs1v < (int32_t) rs2v; break;
+      case 3: v = rs1v < rs2v; break;
+      case 4: v = rs1v ^ rs2v; break;
+      case 5: v = f7 == 0x20 ? (uint32_t) ((int32_t) rs1v >> (rs2v & 31))
+                             : rs1v >> (rs2v & 31); break;
+      case 6: v = rs1v | rs2v; break;
+      default: v = rs1v & rs2v; break;
+      }
+    }
+    if (rd) c->x[rd] = v;
+    break;
+  }
+  case 0x0f:                                  /* fence, fence.i */
+    break;
+  case 0x73: {                                /* system */
+    uint32_t csr = insn >> 20, old, src;
+    if (f3 == 0) {
+      if (insn == 0x00000073) {               /* ecall */
+        trap(c, CAUSE_ECALL_M, 0, 0);
+        return CYC_TRAP;
+      } else if (insn == 0x00100073) {        /* ebreak */
+        trap(c, CAUSE_BREAKPOINT, 0, c->pc);
+        return CYC_TRAP;
+      } else if (insn == 0x30200073) {        /* mret */
+        c->mstatus = (c->mstatus & ~MSTATUS_MIE)
+                   | ((c->mstatus & MSTATUS_MPIE) ? MSTATUS_MIE : 0)
+                   | MSTATUS_MPIE;
+        next = c->mepc;
+        cost = CYC_TRAP;
+      } else if (insn == 0x10500073) {        /* wfi */
+        if ((board_pending(b) & c->mie) == 0)
+          c->waiting = 1;
+      } else {
+        trap(c, CAUSE_ILLEGAL, 0, insn);
+        return CYC_TRAP;
+      }
+      break;
+    }
+    src = (f3 & 4) ? ((insn >> 15) & 31) : rs1v;
+    if (!csr_read(c, b, csr, &old)) {
+      trap(c, CAUSE_ILLEGAL, 0, insn);
+      return CYC_TRAP;
+    }
+    switch (f3 & 3) {
+    case 1:
+      if (!csr_write(c, csr, src)) { trap(c, CAUSE_ILLEGAL, 0, insn); return CYC_TRAP; }
+      break;
+    case 2:
+      if (((insn >> 15) & 31) != 0 && !csr_write(c, csr, old | src)) {
+        trap(c, CAUSE_ILLEGAL, 0, insn);
+        return CYC_TRAP;
+      }
+      break;
+    case 3:
+      if (((insn >> 15) & 31) != 0 && !csr_write(c, csr, old & ~src)) {
+        trap(c, CAUSE_ILLEGAL, 0, insn);
+        return CYC_TRAP;
+      }
+      break;
+    default:
+      trap(c, CAUSE_ILLEGAL, 0, insn);
+      return CYC_TRAP;
+    }
+    if (rd) c->x[rd] = old;
+    cost = CYC_CSR;
+    break;
+  }
+  default:
+    trap(c, CAUSE_ILLEGAL, 0, insn);
+    return CYC_TRAP;
+  }
+
+  c->pc = next;
+  c->instret++;
+  return cost;
+}
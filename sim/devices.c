@@ -0,0 +1,261 @@
+/* devices.c
+
+   DTEK-V peripherals at 0x04000000: LEDs, switch and button PIOs with
+   interrupt mask and edge capture, the interval timer, six 7-segment
+   displays and the JTAG UART. Register behaviour follows the Intel
+   (Altera) IP cores the board uses. */
+
+#include <string.h>
+#include "sim.h"
+
+#define JTAG_FIFO    64
+#define JTAG_RE      0x001
+#define JTAG_WE      0x002
+#define JTAG_WI      0x200
+
+#define TIMER_TO     0x1
+#define TIMER_RUN    0x2
+#define TIMER_ITO    0x1
+#define TIMER_CONT   0x2
+#define TIMER_START  0x4
+#define TIMER_STOP   0x8
+
+void board_init(struct board *b)
+{
+  memset(b, 0, sizeof(*b));
+  b->jtag_irq = -1;
+  b->jtag_space = JTAG_FIFO;
+  b->uart_out = stdout;
+  memset(b->hex, 0xff, sizeof(b->hex));     /* All segments off. */
+}
+
+/* Digit shown by an active-low 7-segment code, or '?' if none. */
+static char hex_digit(uint32_t code)
+{
+  static const uint8_t codes[16] = {
+    0xC0, 0xF9, 0xA4, 0xB0, 0x99, 0x92, 0x82, 0xF8,
+    0x80, 0x90, 0x88, 0x83, 0xC6, 0xA1, 0x86, 0x8E
+  };
+  int i;
+
+  if ((code & 0x7f) == 0x7f)
+    return ' ';
+  for (i = 0; i < 16; i++)
+    if ((code & 0x7f) == (codes[i] & 0x7f))
+      return "0123456789ABCDEF"[i];
+  return '?';
+}
+
+static void pio_set(struct pio *p, uint32_t v)
+{
+  p->edge |= v & ~p->data;                   /* Rising edges. */
+  p->data = v;
+}
+
+static uint32_t pio_read(struct pio *p, uint32_t reg)
+{
+  switch (reg) {
+  case 0x0: return p->data;
+  case 0x4: return p->direction;
+  case 0x8: return p->mask;
+  case 0xc: return p->edge;
+  }
+  return 0;
+}
+
+static void pio_write(struct pio *p, uint32_t reg, uint32_t v)
+{
+  switch (reg) {
+  case 0x4: p->direction = v; break;
+  case 0x8: p->mask = v; break;
+  case 0xc: p->edge = 0; break;              /* Any write clears. */
+  }
+}
+
+static uint32_t timer_read(struct timer *t, uint32_t reg)
+{
+  switch (reg) {
+  case 0x00: return t->status;
+  case 0x04: return t->control & (TIMER_ITO | TIMER_CONT);
+  case 0x08: return t->period & 0xffff;
+  case 0x0c: return t->period >> 16;
+  case 0x10: return t->snap & 0xffff;
+  case 0x14: return t->snap >> 16;
+  }
+  return 0;
+}
+
+static void timer_write(struct timer *t, uint32_t reg, uint32_t v)
+{
+  switch (reg) {
+  case 0x00:
+    t->status &= ~TIMER_TO;
+    break;
+  case 0x04:
+    t->control = v & (TIMER_ITO | TIMER_CONT);
+    if (v & TIMER_STOP)
+      t->status &= ~TIMER_RUN;
+    else if (v & TIMER_START)
+      t->status |= TIMER_RUN;
+    break;
+  case 0x08:
+  case 0x0c:
+    if (reg == 0x08)
+      t->period = (t->period & 0xffff0000u) | (v & 0xffff);
+    else
+      t->period = (t->period & 0xffff) | (v << 16);
+    t->status &= ~TIMER_RUN;                 /* Writing the period stops */
+    t->counter = t->period;                  /* and reloads the counter. */
+    break;
+  case 0x10:
+  case 0x14:
+    t->snap = t->counter;
+    break;
+  }
+}
+
+static void timer_advance(struct timer *t, uint64_t cycles)
+{
+  uint64_t span;
+
+  if (!(t->status & TIMER_RUN))
+    return;
+  if (cycles <= t->counter) {
+    t->counter -= cycles;
+    return;
+  }
+  /* The counter goes period..0, so one timeout every period+1 cycles. */
+  cycles -= (uint64_t) t->counter + 1;
+  t->status |= TIMER_TO;
+  t->timeouts++;
+  if (!(t->control & TIMER_CONT)) {
+    t->status &= ~TIMER_RUN;
+    t->counter = t->period;
+    return;
+  }
+  span = (uint64_t) t->period + 1;
+  t->timeouts += cycles / span;
+  t->counter = t->period - (uint32_t) (cycles % span);
+}
+
+uint32_t mmio_read(struct board *b, struct cpu *c, uint32_t off)
+{
+  (void) c;
+  if (off >= SW_BASE && off < SW_BASE + 0x10)
+    return pio_read(&b->sw, off - SW_BASE);
+  if (off >= BTN_BASE && off < BTN_BASE + 0x10)
+    return pio_read(&b->btn, off - BTN_BASE);
+  if (off >= TIMER_BASE && off < TIMER_BASE + 0x20)
+    return timer_read(&b->timer, off - TIMER_BASE);
+  if (off == LED_BASE)
+    return b->leds;
+  if (off >= HEX_BASE && off < HEX_BASE + 0x60 && (off & 0xf) == 0)
+    return b->hex[(off - HEX_BASE) >> 4];
+  if (off == JTAG_BASE)
+    return 0;                                /* Never any input. */
+  if (off == JTAG_BASE + 4) {
+    uint32_t v = (b->jtag_space << 16) | (b->jtag_ctrl & (JTAG_RE | JTAG_WE));
+    if ((b->jtag_ctrl & JTAG_WE) && b->jtag_space > 0)
+      v |= JTAG_WI;
+    return v;
+  }
+  return 0;
+}
+
+void mmio_write(struct board *b, struct cpu *c, uint32_t off, uint32_t v)
+{
+  if (off >= SW_BASE && off < SW_BASE + 0x10) {
+    pio_write(&b->sw, off - SW_BASE, v);
+  } else if (off >= BTN_BASE && off < BTN_BASE + 0x10) {
+    pio_write(&b->btn, off - BTN_BASE, v);
+  } else if (off >= TIMER_BASE && off < TIMER_BASE + 0x20) {
+    timer_write(&b->timer, off - TIMER_BASE, v);
+  } else if (off == LED_BASE) {
+    if (b->trace_led && (v & 0x3ff) != b->leds)
+      fprintf(stderr, "[%12llu] LEDS 0x%03x\n",
+              (unsigned long long) c->cycle, v & 0x3ff);
+    b->leds = v & 0x3ff;
+  } else if (off >= HEX_BASE && off < HEX_BASE + 0x60 && (off & 0xf) == 0) {
+    int n = (off - HEX_BASE) >> 4;
+    if (b->trace_hex && b->hex[n] != v) {
+      b->hex[n] = v;
+      fprintf(stderr, "[%12llu] HEX %c%c%c%c%c%c\n",
+              (unsigned long long) c->cycle,
+              hex_digit(b->hex[5]), hex_digit(b->hex[4]), hex_digit(b->hex[3]),
+              hex_digit(b->hex[2]), hex_digit(b->hex[1]), hex_digit(b->hex[0]));
+    }
+    b->hex[n] = v;
+  } else if (off == JTAG_BASE) {
+    /* A full FIFO drops the byte, as on the board. */
+    if (b->jtag_space > 0) {
+      if (b->uart_out != NULL) {
+        fputc(v & 0xff, b->uart_out);
+      }
+      b->jtag_bytes++;
+      if (b->jtag_rate != 0) {
+        if (b->jtag_space == JTAG_FIFO)
+          b->jtag_next_drain = c->cycle + b->jtag_rate;
+        b->jtag_space--;
+      }
+    }
+  } else if (off == JTAG_BASE + 4) {
+    b->jtag_ctrl = v & (JTAG_RE | JTAG_WE);
+  }
+}
+
+void board_advance(struct board *b, struct cpu *c, uint64_t cycles)
+{
+  timer_advance(&b->timer, cycles);
+
+  while (b->jtag_rate != 0 && b->jtag_space < JTAG_FIFO
+         && c->cycle >= b->jtag_next_drain) {
+    b->jtag_space++;
+    b->jtag_next_drain += b->jtag_rate;
+  }
+
+  while (b->next_event < b->nevents
+         && b->events[b->next_event].cycle <= c->cycle) {
+    struct input_event *e = &b->events[b->next_event++];
+    pio_set(e->port == SW_BASE ? &b->sw : &b->btn, e->value);
+  }
+}
+
+/* mip as seen by the core. */
+uint32_t board_pending(struct board *b)
+{
+  uint32_t mip = 0;
+
+  if ((b->timer.status & TIMER_TO) && (b->timer.control & TIMER_ITO))
+    mip |= 1u << IRQ_TIMER;
+  if (b->sw.edge & b->sw.mask)
+    mip |= 1u << IRQ_SWITCH;
+  if (b->btn.edge & b->btn.mask)
+    mip |= 1u << IRQ_BUTTON;
+  if (b->jtag_irq >= 0 && (b->jtag_ctrl & JTAG_WE) && b->jtag_space > 0)
+    mip |= 1u << b->jtag_irq;
+  return mip;
+}
+
+/* Earliest cycle at which a device could raise an interrupt. */
+uint64_t board_next_wakeup(struct board *b, struct cpu *c)
+{
+  uint64_t next = UINT64_MAX;
+
+  if ((b->timer.status & TIMER_RUN) && (b->timer.control & TIMER_ITO))
+    next = c->cycle + b->timer.counter + 1;
+  if (b->next_event < b->nevents && b->events[b->next_event].cycle < next)
+    next = b->events[b->next_event].cycle;
+  if (b->jtag_rate != 0 && b->jtag_space < JTAG_FIFO && b->jtag_next_drain < next)
+    next = b->jtag_next_drain;
+  return next;
+}
+
+void board_report(struct board *b, FILE *f)
+{
+  fprintf(f, "hex      %c%c%c%c%c%c\n",
+          hex_digit(b->hex[5]), hex_digit(b->hex[4]), hex_digit(b->hex[3]),
+          hex_digit(b->hex[2]), hex_digit(b->hex[1]), hex_digit(b->hex[0]));
+  fprintf(f, "leds     0x%03x\n", b->leds);
+  fprintf(f, "timeouts %llu\n", (unsigned long long) b->timer.timeouts);
+  fprintf(f, "uart     %llu bytes\n", (unsigned long long) b->jtag_bytes);
+}
@@ -0,0 +1,151 @@
+/* elf.c
+
+   Minimal ELF32 loader: copies PT_LOAD segments into the simulated RAM
+   and keeps the symbol table around for per-function profiling. */
+
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+struct sym {
+  uint32_t addr;
+  char *name;
+};
+
+static struct sym *syms;
+static int nsyms;
+
+static int sym_cmp(const void *a, const void *b)
+{
+  const struct sym *x = a, *y = b;
+  return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+static void load_symbols(const uint8_t *img, size_t size, const Elf32_Ehdr *eh)
+{
+  const Elf32_Shdr *sh = (const Elf32_Shdr *) (img + eh->e_shoff);
+  int i;
+
+  if (eh->e_shoff == 0 || eh->e_shoff + eh->e_shnum * sizeof(*sh) > size)
+    return;
+  for (i = 0; i < eh->e_shnum; i++) {
+    const Elf32_Sym *st;
+    const char *strtab;
+    unsigned n, k;
+
+    if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh->e_shnum)
+      continue;
+    st = (const Elf32_Sym *) (img + sh[i].sh_offset);
+    strtab = (const char *) (img + sh[sh[i].sh_link].sh_offset);
+    n = sh[i].sh_size / sizeof(*st);
+    syms = calloc(n, sizeof(*syms));
+    for (k = 0; k < n; k++) {
+      int type = ELF32_ST_TYPE(st[k].st_info);
+      const char *name = strtab + st[k].st_name;
+
+      /* Functions, plus the untyped labels that assembly files export. */
+      if (type != STT_FUNC && type != STT_NOTYPE)
+        continue;
+      if (st[k].st_shndx == SHN_UNDEF || st[k].st_shndx >= eh->e_shnum)
+        continue;
+      if (!(sh[st[k].st_shndx].sh_flags & SHF_EXECINSTR))
+        continue;
+      if (name[0] == '\0' || name[0] == '.' || name[0] == '$')
+        continue;
+      syms[nsyms].addr = st[k].st_value;
+      syms[nsyms].name = strdup(name);
+      nsyms++;
+    }
+    qsort(syms, nsyms, sizeof(*syms), sym_cmp);
+    return;
+  }
+}
+
+int elf_load(const char *path, uint32_t *entry)
+{
+  FILE *f = fopen(path, "rb");
+  uint8_t *img;
+  long size;
+  const Elf32_Ehdr *eh;
+  const Elf32_Phdr *ph;
+  int i;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  img = malloc(size);
+  if (fread(img, 1, size, f) != (size_t) size) {
+    fprintf(stderr, "%s: short read\n", path);
+    fclose(f);
+    return -1;
+  }
+  fclose(f);
+
+  eh = (const Elf32_Ehdr *) img;
+  if (size < (long) sizeof(*eh) || memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0
+      || eh->e_ident[EI_CLASS] != ELFCLASS32 || eh->e_machine != EM_RISCV) {
+    fprintf(stderr, "%s: not a 32-bit RISC-V ELF file\n", path);
+    return -1;
+  }
+
+  ph = (const Elf32_Phdr *) (img + eh->e_phoff);
+  for (i = 0; i < eh->e_phnum; i++) {
+    if (ph[i].p_type != PT_LOAD)
+      continue;
+    if (ph[i].p_paddr + ph[i].p_memsz > RAM_SIZE) {
+      fprintf(stderr, "%s: segment at 0x%08x does not fit in RAM\n",
+              path, ph[i].p_paddr);
+      return -1;
+    }
+    memcpy(ram + ph[i].p_paddr, img + ph[i].p_offset, ph[i].p_filesz);
+    memset(ram + ph[i].p_paddr + ph[i].p_filesz, 0,
+           ph[i].p_memsz - ph[i].p_filesz);
+  }
+  *entry = eh->e_entry;
+  load_symbols(img, size, eh);
+  free(img);
+  return 0;
+}
+
+/* Index of the symbol containing addr, or -1. */
+int elf_symbol_index(uint32_t addr)
+{
+  int lo = 0, hi = nsyms - 1, best = -1;
+
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (syms[mid].addr <= addr) {
+      best = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return best;
+}
+
+const char *elf_symbol(uint32_t addr, uint32_t *start)
+{
+  int i = elf_symbol_index(addr);
+
+  if (i < 0)
+    return NULL;
+  if (start != NULL)
+    *start = syms[i].addr;
+  return syms[i].name;
+}
+
+int elf_symbol_count(void)
+{
+  return nsyms;
+}
+
+const char *elf_symbol_name(int i)
+{
+  return syms[i].name;
+}
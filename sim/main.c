@@ -0,0 +1,182 @@
+/* main.c
+
+   dtekv-sim command line driver.
+
+   Usage: dtekv-sim [options] main.elf
+
+     --max-cycles N     stop after N cycles (default 300000000, 10 s)
+     --max-insns N      stop after N instructions
+     --sw CYCLE:VALUE   set the switches to VALUE at CYCLE (repeatable)
+     --btn CYCLE:VALUE  set the buttons to VALUE at CYCLE (repeatable)
+     --uart-rate N      host drains one JTAG UART byte every N cycles
+                        (default 0: the FIFO never fills)
+     --jtag-irq N       raise mip bit N for the JTAG UART write interrupt
+     --trace-hex        log every change of the 7-segment displays
+     --trace-leds       log every change of the LEDs
+     --prof             print cycles spent per function
+     --mhz F            clock used to convert cycles to time (default 30)
+     -q                 do not echo JTAG UART output
+
+   UART output goes to stdout, everything else to stderr. Numbers may
+   be given in decimal or with a 0x prefix. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+uint8_t *ram;
+
+static struct input_event events[256];
+static int nevents;
+
+static void usage(void)
+{
+  fprintf(stderr, "usage: dtekv-sim [--max-cycles N] [--max-insns N] "
+          "[--sw C:V] [--btn C:V] [--uart-rate N] [--jtag-irq N] "
+          "[--trace-hex] [--trace-leds] [--prof] [--mhz F] [-q] main.elf\n");
+  exit(2);
+}
+
+static void add_event(int port, const char *arg)
+{
+  char *end;
+  struct input_event *e;
+
+  if (nevents == (int) (sizeof(events) / sizeof(events[0]))) {
+    fprintf(stderr, "too many input events\n");
+    exit(2);
+  }
+  e = &events[nevents++];
+  e->port = port;
+  e->cycle = strtoull(arg, &end, 0);
+  if (*end != ':')
+    usage();
+  e->value = strtoul(end + 1, NULL, 0);
+}
+
+static int event_cmp(const void *a, const void *b)
+{
+  const struct input_event *x = a, *y = b;
+  return (x->cycle > y->cycle) - (x->cycle < y->cycle);
+}
+
+struct prof_row {
+  const char *name;
+  uint64_t cycles;
+};
+
+static int prof_cmp(const void *a, const void *b)
+{
+  const struct prof_row *x = a, *y = b;
+  return (x->cycles < y->cycles) - (x->cycles > y->cycles);
+}
+
+static void report_prof(const uint64_t *prof, uint64_t total)
+{
+  int n = elf_symbol_count(), i;
+  struct prof_row *rows = calloc(n + 1, sizeof(*rows));
+
+  for (i = 0; i < n; i++) {
+    rows[i].name = elf_symbol_name(i);
+    rows[i].cycles = prof[i];
+  }
+  rows[n].name = "(unknown)";
+  rows[n].cycles = prof[n];
+  qsort(rows, n + 1, sizeof(*rows), prof_cmp);
+  fprintf(stderr, "%-24s %14s %7s\n", "function", "cycles", "%");
+  for (i = 0; i <= n && rows[i].cycles != 0; i++)
+    fprintf(stderr, "%-24s %14llu %6.2f%%\n", rows[i].name,
+            (unsigned long long) rows[i].cycles,
+            100.0 * rows[i].cycles / (total ? total : 1));
+  free(rows);
+}
+
+int main(int argc, char **argv)
+{
+  static struct cpu cpu;
+  static struct board board;
+  uint64_t max_cycles = 300000000ull, max_insns = UINT64_MAX;
+  uint64_t *prof = NULL;
+  double mhz = 30.0;
+  const char *path = NULL;
+  uint32_t entry;
+  int do_prof = 0, i;
+
+  board_init(&board);
+  for (i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    const char *v = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+    if (!strcmp(a, "--max-cycles") && v) { max_cycles = strtoull(v, NULL, 0); i++; }
+    else if (!strcmp(a, "--max-insns") && v) { max_insns = strtoull(v, NULL, 0); i++; }
+    else if (!strcmp(a, "--sw") && v) { add_event(SW_BASE, v); i++; }
+    else if (!strcmp(a, "--btn") && v) { add_event(BTN_BASE, v); i++; }
+    else if (!strcmp(a, "--uart-rate") && v) { board.jtag_rate = strtoul(v, NULL, 0); i++; }
+    else if (!strcmp(a, "--jtag-irq") && v) { board.jtag_irq = atoi(v) & 31; i++; }
+    else if (!strcmp(a, "--mhz") && v) { mhz = atof(v); i++; }
+    else if (!strcmp(a, "--trace-hex")) board.trace_hex = 1;
+    else if (!strcmp(a, "--trace-leds")) board.trace_led = 1;
+    else if (!strcmp(a, "--prof")) do_prof = 1;
+    else if (!strcmp(a, "-q")) board.uart_out = NULL;
+    else if (a[0] == '-' || path != NULL) usage();
+    else path = a;
+  }
+  if (path == NULL)
+    usage();
+
+  qsort(events, nevents, sizeof(events[0]), event_cmp);
+  board.events = events;
+  board.nevents = nevents;
+
+  ram = calloc(1, RAM_SIZE);
+  if (ram == NULL || elf_load(path, &entry) != 0)
+    return 1;
+  cpu_reset(&cpu, entry);
+  if (do_prof)
+    prof = calloc(elf_symbol_count() + 1, sizeof(*prof));
+
+  while (!cpu.halted && cpu.cycle < max_cycles && cpu.instret < max_insns) {
+    uint32_t pc = cpu.pc;
+    unsigned cost = cpu_step(&cpu, &board);
+
+    if (cpu.waiting) {
+      /* Parked in wfi: skip straight to the next device event. */
+      uint64_t wake = board_next_wakeup(&board, &cpu);
+      if (wake == UINT64_MAX) {
+        cpu.halted = 1;
+        cpu.halt_reason = "wfi with no interrupt source armed";
+        break;
+      }
+      if (wake > max_cycles)
+        wake = max_cycles;
+      cost = wake > cpu.cycle ? (unsigned) (wake - cpu.cycle) : 1;
+    }
+    if (prof != NULL) {
+      int s = elf_symbol_index(pc);
+      prof[s < 0 ? elf_symbol_count() : s] += cost;
+    }
+    cpu.cycle += cost;
+    board_advance(&board, &cpu, cost);
+  }
+  if (board.uart_out != NULL)
+    fflush(board.uart_out);
+
+  fprintf(stderr, "\n--- dtekv-sim ---\n");
+  fprintf(stderr, "stop     %s\n", cpu.halted ? cpu.halt_reason
+          : cpu.cycle >= max_cycles ? "cycle limit" : "instruction limit");
+  fprintf(stderr, "pc       0x%08x\n", cpu.pc);
+  fprintf(stderr, "cycles   %llu (%.6f s at %g MHz)\n",
+          (unsigned long long) cpu.cycle, cpu.cycle / (mhz * 1e6), mhz);
+  fprintf(stderr, "insns    %llu (CPI %.3f)\n", (unsigned long long) cpu.instret,
+          cpu.instret ? (double) cpu.cycle / cpu.instret : 0.0);
+  for (i = 0; i < 32; i++)
+    if (cpu.irqs[i] != 0)
+      fprintf(stderr, "irq %-4d %llu\n", i, (unsigned long long) cpu.irqs[i]);
+  for (i = 0; i < 32; i++)
+    if (cpu.traps[i] != 0)
+      fprintf(stderr, "trap %-3d %llu\n", i, (unsigned long long) cpu.traps[i]);
+  board_report(&board, stderr);
+  if (prof != NULL)
+    report_prof(prof, cpu.cycle);
+  return 0;
+}
@@ -0,0 +1,121 @@
+/* sim.h
+
+   dtekv-sim: host-side RV32IM + Zicsr simulator for the DTEK-V board.
+
+   The CPU model executes one instruction per step and charges it a
+   cycle cost from the table below. The costs are a rough model of a
+   short in-order pipeline: absolute numbers are estimates, but they
+   are stable, so before/after comparisons of the same code are
+   meaningful. The peripherals are advanced by the same cycle count,
+   so the interval timer runs at "CPU speed" just like on the board. */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define RAM_BASE  0x00000000u
+#define RAM_SIZE  (32u << 20)             /* Matches dtekv-script.lds. */
+#define MMIO_BASE 0x04000000u
+#define MMIO_SIZE 0x00000100u
+
+/* Per-instruction cycle costs. */
+#define CYC_ALU        1
+#define CYC_LOAD       2
+#define CYC_STORE      1
+#define CYC_BRANCH     1                  /* Not taken. */
+#define CYC_TAKEN      3                  /* Taken branch, jal, jalr. */
+#define CYC_MUL        1
+#define CYC_DIV        33
+#define CYC_CSR        1
+#define CYC_TRAP       4                  /* Trap entry or mret. */
+
+/* Interrupt lines as seen in mip/mie and mcause. */
+#define IRQ_TIMER    16
+#define IRQ_SWITCH   17
+#define IRQ_BUTTON   18
+
+/* Board I/O register offsets from MMIO_BASE. */
+#define LED_BASE     0x00
+#define SW_BASE      0x10
+#define TIMER_BASE   0x20
+#define JTAG_BASE    0x40
+#define HEX_BASE     0x50                 /* Six displays, 0x10 apart. */
+#define BTN_BASE     0xd0
+
+struct cpu {
+  uint32_t x[32];
+  uint32_t pc;
+
+  uint32_t mstatus, mie, mtvec, mscratch, mepc, mcause, mtval;
+  uint64_t cycle;                         /* mcycle */
+  uint64_t instret;                       /* minstret */
+
+  int waiting;                            /* Parked in wfi. */
+  int halted;
+  const char *halt_reason;
+
+  uint64_t traps[32];                     /* Synchronous traps by cause. */
+  uint64_t irqs[32];                      /* Interrupts by cause. */
+};
+
+/* A scheduled change of an input port, from the command line. */
+struct input_event {
+  uint64_t cycle;
+  int port;                               /* SW_BASE or BTN_BASE */
+  uint32_t value;
+};
+
+struct pio {
+  uint32_t data, direction, mask, edge;
+};
+
+struct timer {
+  uint32_t status, control, period, counter, snap;
+  uint64_t timeouts;
+};
+
+struct board {
+  uint32_t leds;
+  uint32_t hex[6];
+  struct pio sw, btn;
+  struct timer timer;
+
+  uint32_t jtag_ctrl;
+  int jtag_irq;                           /* mip bit for the UART, or -1. */
+  uint32_t jtag_space;                    /* Free TX FIFO slots. */
+  uint32_t jtag_rate;                     /* Cycles per byte drained, 0 = instant. */
+  uint64_t jtag_next_drain;
+  uint64_t jtag_bytes;
+
+  struct input_event *events;
+  int nevents, next_event;
+
+  int trace_hex, trace_led;
+  FILE *uart_out;
+};
+
+extern uint8_t *ram;
+
+/* elf.c */
+int elf_load(const char *path, uint32_t *entry);
+const char *elf_symbol(uint32_t addr, uint32_t *start);
+int elf_symbol_index(uint32_t addr);
+int elf_symbol_count(void);
+const char *elf_symbol_name(int i);
+
+/* devices.c */
+void board_init(struct board *b);
+uint32_t mmio_read(struct board *b, struct cpu *c, uint32_t off);
+void mmio_write(struct board *b, struct cpu *c, uint32_t off, uint32_t v);
+void board_advance(struct board *b, struct cpu *c, uint64_t cycles);
+uint32_t board_pending(struct board *b);
+uint64_t board_next_wakeup(struct board *b, struct cpu *c);
+void board_report(struct board *b, FILE *f);
+
+/* cpu.c */
+void cpu_reset(struct cpu *c, uint32_t entry);
+unsigned cpu_step(struct cpu *c, struct board *b);
+
+#endif
@@ -0,0 +1,74 @@
+/* clock.c */
+
+#include "clock.h"
+
+void clock_add_seconds(int *hours, int *minutes, int *seconds, int n)
+{
+  int s = *seconds + n, m = *minutes, h = *hours;
+
+  while (s >= 60) {
+    s -= 60;
+    if (++m >= 60) {
+      m = 0;
+      if (++h >= 24)
+        h = 0;
+    }
+  }
+  *hours = h;
+  *minutes = m;
+  *seconds = s;
+}
+
+void clock_set_from_switches(int *hours, int *minutes, int *seconds,
+                             unsigned switches)
+{
+  int value = switches & 0x3F;
+
+  switch ((switches >> 8) & 0x03) {
+  case 1:
+    *seconds = value < 60 ? value : 59;
+    break;
+  case 2:
+    *minutes = value < 60 ? value : 59;
+    break;
+  case 3:
+    *hours = value < 24 ? value : 23;
+    break;
+  }
+}
+
+/* Same digit-by-digit carry as the assembly: each digit that rolls
+   over is pushed on to the next by adding the gap to its base. */
+void clock_tick(int *t)
+{
+  int v = *t + 1;
+
+  if ((v & 0xf) >= 0xa) {
+    v += 0x6;
+    if ((v & 0xf0) >= 0x60) {
+      v += 0xa0;
+      if ((v & 0xf00) >= 0xa00) {
+        v += 0x600;
+        if ((v & 0xf000) >= 0x6000)
+          v += 0xa000;
+      }
+    }
+  }
+  *t = v;
+}
+
+static inline char hexasc(unsigned d)
+{
+  d &= 0xf;
+  return d < 10 ? '0' + d : 'A' + d - 10;
+}
+
+void clock_time2string(char *buf, int t)
+{
+  buf[0] = hexasc(t >> 12);
+  buf[1] = hexasc(t >> 8);
+  buf[2] = ':';
+  buf[3] = hexasc(t >> 4);
+  buf[4] = hexasc(t);
+  buf[5] = '\0';
+}
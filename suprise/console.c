@@ -0,0 +1,123 @@
+/* console.c
+
+   TX ring buffer in front of the JTAG UART. head is advanced by
+   writers and tail by the drain; both may run from main or from an
+   interrupt handler, so each touches the indices with MIE cleared.
+   The critical sections are bounded by the UART FIFO depth, never by
+   the host's drain rate. */
+
+#include "console.h"
+#include "dtekv-hw.h"
+#include "sync.h"
+
+#define JTAG_CTRL_WE 0x2                /* Write interrupt enable. */
+#define CONSOLE_MASK (CONSOLE_BUF_SIZE - 1)
+
+static char tx_buf[CONSOLE_BUF_SIZE];
+static unsigned tx_head;                /* Next free slot. */
+static unsigned tx_tail;                /* Oldest queued byte. */
+static unsigned tx_dropped;
+static int tx_policy = CONSOLE_BLOCK;  /* Lossless, like the old printc. */
+static int tx_use_irq;
+
+/* Send one burst. Caller holds the critical section. */
+static void drain_locked(void)
+{
+  struct dtekv_jtag_uart *uart = HW_JTAG_UART;
+  unsigned space = HW_READ(uart->control) >> 16;
+  unsigned pending = tx_head - tx_tail;
+
+  if (space > pending)
+    space = pending;
+  while (space-- != 0)
+    HW_WRITE(uart->data, tx_buf[tx_tail++ & CONSOLE_MASK]);
+
+  if (tx_use_irq)
+    HW_WRITE(uart->control, (tx_head != tx_tail) ? JTAG_CTRL_WE : 0);
+}
+
+void console_set_policy(int policy)
+{
+  tx_policy = policy;
+}
+
+int console_write(const char *buf, int len)
+{
+  unsigned flags;
+  int done = 0;
+
+  while (done < len) {
+    unsigned room, n;
+
+    flags = irq_save();
+    room = CONSOLE_BUF_SIZE - (tx_head - tx_tail);
+    if (room == 0) {
+      drain_locked();
+      room = CONSOLE_BUF_SIZE - (tx_head - tx_tail);
+    }
+    if (room == 0) {
+      if (tx_policy == CONSOLE_DROP) {
+        tx_dropped += len - done;
+        irq_restore(flags);
+        return done;
+      }
+      if (tx_policy == CONSOLE_OVERWRITE) {
+        tx_tail++;
+        tx_dropped++;
+        room = 1;
+      } else {
+        /* CONSOLE_BLOCK: let pending interrupts in, then retry. */
+        irq_restore(flags);
+        continue;
+      }
+    }
+    n = len - done;
+    if (n > room)
+      n = room;
+    while (n-- != 0)
+      tx_buf[tx_head++ & CONSOLE_MASK] = buf[done++];
+    drain_locked();
+    irq_restore(flags);
+  }
+  return done;
+}
+
+void console_putc(char c)
+{
+  console_write(&c, 1);
+}
+
+void console_poll(void)
+{
+  unsigned flags;
+
+  if (tx_head == tx_tail)
+    return;
+  flags = irq_save();
+  drain_locked();
+  irq_restore(flags);
+}
+
+void console_flush(void)
+{
+  while (tx_head != tx_tail)
+    console_poll();
+}
+
+void console_irq(unsigned cause)
+{
+  drain_locked();
+}
+
+void console_use_irq(int on)
+{
+  unsigned flags = irq_save();
+  tx_use_irq = on;
+  HW_WRITE(HW_JTAG_UART->control, (on && tx_head != tx_tail) ? JTAG_CTRL_WE : 0);
+  irq_restore(flags);
+}
+
+unsigned console_dropped(void)
+{
+  return tx_dropped;
+}
@@ -0,0 +1,101 @@
+/* display.c
+
+   Segment codes are active low, bit0=A ... bit6=G. pair_segs[v]
+   holds the codes for both digits of v (tens in the high byte), so a
+   0..99 field is shown without dividing by ten. */
+
+#include "display.h"
+#include "dtekv-hw.h"
+
+#define S0 0xC0
+#define S1 0xF9
+#define S2 0xA4
+#define S3 0xB0
+#define S4 0x99
+#define S5 0x92
+#define S6 0x82
+#define S7 0xF8
+#define S8 0x80
+#define S9 0x90
+
+#define PAIR(t, u) ((S##t << 8) | S##u)
+#define ROW(t) PAIR(t, 0), PAIR(t, 1), PAIR(t, 2), PAIR(t, 3), PAIR(t, 4), \
+               PAIR(t, 5), PAIR(t, 6), PAIR(t, 7), PAIR(t, 8), PAIR(t, 9)
+
+static const unsigned short pair_segs[100] = {
+  ROW(0), ROW(1), ROW(2), ROW(3), ROW(4),
+  ROW(5), ROW(6), ROW(7), ROW(8), ROW(9)
+};
+
+/* 0-9 and A-F, for BCD and hex nibbles. */
+static const unsigned char nibble_segs[16] = {
+  S0, S1, S2, S3, S4, S5, S6, S7, S8, S9,
+  0x88, 0x83, 0xC6, 0xA1, 0x86, 0x8E
+};
+
+/* The hardware state is unknown at reset, so everything starts dirty. */
+static unsigned char fb[DISPLAY_DIGITS] = {
+  DISPLAY_BLANK, DISPLAY_BLANK, DISPLAY_BLANK,
+  DISPLAY_BLANK, DISPLAY_BLANK, DISPLAY_BLANK
+};
+static unsigned char shown[DISPLAY_DIGITS];
+static unsigned dirty = (1u << DISPLAY_DIGITS) - 1;
+
+static inline void put(int n, unsigned char segments)
+{
+  fb[n] = segments;
+  if (segments != shown[n])
+    dirty |= 1u << n;
+}
+
+void display_raw(int n, unsigned char segments)
+{
+  if ((unsigned) n < DISPLAY_DIGITS)
+    put(n, segments);
+}
+
+void display_digit(int n, int value)
+{
+  display_raw(n, (unsigned) value <= 9 ? nibble_segs[value] : DISPLAY_BLANK);
+}
+
+void display_pair(int pair, unsigned value)
+{
+  unsigned segs;
+
+  if ((unsigned) pair >= DISPLAY_DIGITS / 2)
+    return;
+  segs = value <= 99 ? pair_segs[value] : (DISPLAY_BLANK << 8) | DISPLAY_BLANK;
+  put(2 * pair, segs & 0xff);
+  put(2 * pair + 1, segs >> 8);
+}
+
+void display_clock(int hours, int minutes, int seconds)
+{
+  display_pair(0, seconds);
+  display_pair(1, minutes);
+  display_pair(2, hours);
+}
+
+void display_bcd(unsigned bcd)
+{
+  int n;
+
+  for (n = 0; n < DISPLAY_DIGITS; n++, bcd >>= 4)
+    put(n, nibble_segs[bcd & 0xf]);
+}
+
+void display_flush(void)
+{
+  struct dtekv_pio *hex = HW_HEX;
+  unsigned d = dirty;
+  int n;
+
+  dirty = 0;
+  for (n = 0; d != 0; n++, d >>= 1) {
+    if (d & 1) {
+      shown[n] = fb[n];
+      HW_WRITE(hex[n].data, fb[n]);
+    }
+  }
+}
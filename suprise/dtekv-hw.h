@@ -0,0 +1,151 @@
+/* dtekv-hw.h
+
+   Register overlays for the DTEK-V peripherals.
+
+   Every device is a struct placed at its base address, so an access
+   is one load or store at a constant offset from a base the compiler
+   can keep in a register:
+
+     struct dtekv_timer *t = HW_TIMER;
+     t->status = 0;
+     t->control = TIMER_START | TIMER_CONT | TIMER_ITO;
+
+   All register accesses in the accessors below go through HW_READ and
+   HW_WRITE. A build that wants to trace or fake the hardware can
+   define both before including this file. With -DDTEKV_HOST the
+   devices are in-memory registers instead (host/dtekv-host.h). */
+
+#ifndef DTEKV_HW_H
+#define DTEKV_HW_H
+
+/* Interval timer. Only the low 16 bits of each register are used. */
+struct dtekv_timer {
+  volatile unsigned int status;         /* +0x00 */
+  volatile unsigned int control;        /* +0x04 */
+  volatile unsigned int periodl;        /* +0x08 */
+  volatile unsigned int periodh;        /* +0x0C */
+  volatile unsigned int snapl;          /* +0x10; any write latches */
+  volatile unsigned int snaph;          /* +0x14 */
+};
+
+/* Parallel I/O port: LEDs, switches, buttons and each 7-seg digit. */
+struct dtekv_pio {
+  volatile unsigned int data;           /* +0x00 */
+  volatile unsigned int direction;      /* +0x04 */
+  volatile unsigned int irq_mask;       /* +0x08 */
+  volatile unsigned int edge_capture;   /* +0x0C; any write clears */
+};
+
+struct dtekv_jtag_uart {
+  volatile unsigned int data;           /* +0x00 */
+  volatile unsigned int control;        /* +0x04; WSPACE in 31:16 */
+};
+
+#define HW_BASE      0x04000000
+
+#ifdef DTEKV_HOST
+#include "dtekv-host.h"
+#define HW_DEV(type, addr) ((type*) &host_mmio[((addr) - HW_BASE) / 4])
+#else
+#define HW_DEV(type, addr) ((type*) (addr))
+#endif
+
+#define HW_LEDS      HW_DEV(struct dtekv_pio, 0x04000000)
+#define HW_SWITCHES  HW_DEV(struct dtekv_pio, 0x04000010)
+#define HW_TIMER     HW_DEV(struct dtekv_timer, 0x04000020)
+#define HW_JTAG_UART HW_DEV(struct dtekv_jtag_uart, 0x04000040)
+#define HW_HEX       HW_DEV(struct dtekv_pio, 0x04000050)  /* HW_HEX[0..5] */
+#define HW_BUTTONS   HW_DEV(struct dtekv_pio, 0x040000d0)
+
+#define HW_HEX_COUNT 6
+
+/* Timer status bits. */
+#define TIMER_TO     0x1                /* Timeout; write 0 to clear. */
+#define TIMER_RUN    0x2
+
+/* Timer control bits. */
+#define TIMER_ITO    0x1                /* Interrupt on timeout. */
+#define TIMER_CONT   0x2                /* Reload and keep counting. */
+#define TIMER_START  0x4
+#define TIMER_STOP   0x8
+
+#ifndef HW_WRITE
+#define HW_WRITE(reg, val) ((reg) = (val))
+#define HW_READ(reg)       (reg)
+#endif
+
+static inline void hw_timer_set_period(unsigned cycles)
+{
+  struct dtekv_timer *t = HW_TIMER;
+  HW_WRITE(t->periodl, cycles & 0xffff);
+  HW_WRITE(t->periodh, cycles >> 16);
+}
+
+/* Restart counting down from cycles with the given control bits. */
+static inline void hw_timer_start(unsigned cycles, unsigned control)
+{
+  struct dtekv_timer *t = HW_TIMER;
+  HW_WRITE(t->control, TIMER_STOP);
+  HW_WRITE(t->periodl, cycles & 0xffff);
+  HW_WRITE(t->periodh, cycles >> 16);
+  HW_WRITE(t->status, 0);
+  HW_WRITE(t->control, control | TIMER_START);
+}
+
+static inline void hw_timer_stop(void)
+{
+  HW_WRITE(HW_TIMER->control, TIMER_STOP);
+}
+
+static inline int hw_timer_timeout(void)
+{
+  return HW_READ(HW_TIMER->status) & TIMER_TO;
+}
+
+static inline void hw_timer_ack(void)
+{
+  HW_WRITE(HW_TIMER->status, 0);
+}
+
+/* Current counter value, latched through the snapshot registers. */
+static inline unsigned hw_timer_snapshot(void)
+{
+  struct dtekv_timer *t = HW_TIMER;
+  HW_WRITE(t->snapl, 0);
+  return (HW_READ(t->snaph) << 16) | (HW_READ(t->snapl) & 0xffff);
+}
+
+static inline unsigned hw_switches(void)
+{
+  return HW_READ(HW_SWITCHES->data) & 0x3ff;
+}
+
+static inline unsigned hw_buttons(void)
+{
+  return HW_READ(HW_BUTTONS->data);
+}
+
+static inline void hw_leds(unsigned mask)
+{
+  HW_WRITE(HW_LEDS->data, mask);
+}
+
+/* Raw segment pattern for one digit, active low. */
+static inline void hw_hex(int n, unsigned segments)
+{
+  HW_WRITE(HW_HEX[n].data, segments);
+}
+
+/* All six digits, seg[0] rightmost, from one base register. */
+static inline void hw_hex_all(const unsigned char seg[HW_HEX_COUNT])
+{
+  struct dtekv_pio *hex = HW_HEX;
+  HW_WRITE(hex[0].data, seg[0]);
+  HW_WRITE(hex[1].data, seg[1]);
+  HW_WRITE(hex[2].data, seg[2]);
+  HW_WRITE(hex[3].data, seg[3]);
+  HW_WRITE(hex[4].data, seg[4]);
+  HW_WRITE(hex[5].data, seg[5]);
+}
+
+#endif
@@ -1,56 +1,73 @@
 #include "dtekv-lib.h"
+#include "console.h"
+#include "fmt.h"
 
-#define JTAG_UART ((volatile unsigned int*) 0x04000040)
-#define JTAG_CTRL ((volatile unsigned int*) 0x04000044)
-
+/* Output goes through the buffered console and never waits on the
+   JTAG UART unless the console policy is CONSOLE_BLOCK. */
 void printc(char s)
 {
-    while (((*JTAG_CTRL)&0xffff0000) == 0);
-    *JTAG_UART = s;
+    console_putc(s);
 }
 
 void print(char *s)
 {  
-  while (*s != '\0') {    
-      printc(*s);
-      s++;
-  }
+  int len = 0;
+  while (s[len] != '\0')
+      len++;
+  console_write(s, len);
 }
 
 void print_dec(unsigned int x)
 {
-  unsigned divident = 1000000000;
+  char buf[12];
+  console_write(buf, fmt_udec(buf, x));
+}
+
+void print_dec64(unsigned long long x)
+{
+  /* Digits by repeated subtraction: rv32 has no 64-bit divide
+     instruction and libgcc is not linked. */
+  static const unsigned long long pow10[20] = {
+    10000000000000000000ull, 1000000000000000000ull, 100000000000000000ull,
+    10000000000000000ull, 1000000000000000ull, 100000000000000ull,
+    10000000000000ull, 1000000000000ull, 100000000000ull,
+    10000000000ull, 1000000000ull, 100000000ull,
+    10000000ull, 1000000ull, 100000ull,
+    10000ull, 1000ull, 100ull,
+    10ull, 1ull
+  };
   char first = 0;
-  do {
-    int dv = x / divident;
+  int i;
+
+  if ((x >> 32) == 0) {
+    print_dec((unsigned) x);
+    return;
+  }
+  for (i = 0; i < 20; i++) {
+    int dv = 0;
+    while (x >= pow10[i]) {
+      x -= pow10[i];
+      dv++;
+    }
     if (dv != 0) first = 1;
     if (first != 0)
       printc(48+dv);
-    x -= dv*divident;
-    divident /= 10;
-  } while (divident != 0);
-    if (first == 0)
-	printc(48);
+  }
 }
 
 void print_hex32 ( unsigned int x)
 {
-  printc('0');
-  printc('x');
-  for (int i = 7; i >= 0; i--) {
-    char hd = (char) ((x >> (i*4)) & 0xf);
-    if (hd < 10)
-      hd += '0';
-    else
-      hd += ('A' - 10);
-    printc(hd);
-  }   
+  char buf[12];
+  buf[0] = '0';
+  buf[1] = 'x';
+  console_write(buf, 2 + fmt_hex32(buf + 2, x));
 }
 
 /* function: handle_exception
    Description: This code handles an exception. */
 void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned arg3, unsigned arg4, unsigned arg5, unsigned mcause, unsigned syscall_num )
 {
+  console_set_policy(CONSOLE_BLOCK);    /* Never lose the crash report. */
   switch (mcause)
     {
     case 0:
@@ -59,13 +76,6 @@ void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned ar
     case 2:
       print("\n[EXCEPTION] Illegal instruction. "); 
       break;
-    case 11:
-      if (syscall_num == 4)
-	print((char*) arg0); 
-      if (syscall_num == 11)
-	printc(arg0);
-      return ;
-      break;
     default:
       print("\n[EXCEPTION] Unknown error. ");
       break;
@@ -73,6 +83,7 @@ void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned ar
   
   print("Exception Address: ");
   print_hex32(arg0); printc('\n');
+  console_flush();
   while (1);
 }
 
@@ -81,10 +92,168 @@ void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned ar
  * 
  * Return the first prime number larger than the integer
  * given as a parameter. The integer must be positive.
+ * The result must also fit in an int, i.e. inval < 2147483647.
+ *
+ * Candidates are first run through a division-free filter of
+ * the odd primes up to 61 and then through a deterministic
+ * Miller-Rabin test with bases 2, 7 and 61, which is exact for
+ * every n < 2^32. All modular arithmetic is done in Montgomery
+ * form, so the inner loop is mul/mulhu only and never touches
+ * the divider.
  */
+
 #define PRIME_FALSE   0     /* Constant to help readability. */
 #define PRIME_TRUE    1     /* Constant to help readability. */
+
+/* Odd primes below 64, one bit per number (bit n set if n is prime). */
+#define SMALL_PRIMES_LO 0xA08A28ACu     /* 0..31 */
+#define SMALL_PRIMES_HI 0x28208A20u     /* 32..63 */
+
+/* n is divisible by the odd p iff n * p^-1 (mod 2^32) <= (2^32-1)/p. */
+static const unsigned small_prime_filter[][2] = {
+  { 0xAAAAAAABu, 0x55555555u }, /* 3 */
+  { 0xCCCCCCCDu, 0x33333333u }, /* 5 */
+  { 0xB6DB6DB7u, 0x24924924u }, /* 7 */
+  { 0xBA2E8BA3u, 0x1745D174u }, /* 11 */
+  { 0xC4EC4EC5u, 0x13B13B13u }, /* 13 */
+  { 0xF0F0F0F1u, 0x0F0F0F0Fu }, /* 17 */
+  { 0x286BCA1Bu, 0x0D79435Eu }, /* 19 */
+  { 0xE9BD37A7u, 0x0B21642Cu }, /* 23 */
+  { 0x4F72C235u, 0x08D3DCB0u }, /* 29 */
+  { 0xBDEF7BDFu, 0x08421084u }, /* 31 */
+  { 0x914C1BADu, 0x06EB3E45u }, /* 37 */
+  { 0xC18F9C19u, 0x063E7063u }, /* 41 */
+  { 0x2FA0BE83u, 0x05F417D0u }, /* 43 */
+  { 0x677D46CFu, 0x0572620Au }, /* 47 */
+  { 0x8C13521Du, 0x04D4873Eu }, /* 53 */
+  { 0xA08AD8F3u, 0x0456C797u }, /* 59 */
+  { 0xC10C9715u, 0x04325C53u }, /* 61 */
+};
+#define SMALL_PRIME_COUNT (sizeof(small_prime_filter) / sizeof(small_prime_filter[0]))
+#define SMALL_PRIME_SQUARE (67 * 67)   /* Next prime after the table, squared. */
+
+/* -n^-1 mod 2^32 for odd n, by Newton iteration (3, 6, 12, 24, 48 bits). */
+static unsigned mont_ninv(unsigned n)
+{
+  unsigned x = n;
+  x *= 2 - n * x;
+  x *= 2 - n * x;
+  x *= 2 - n * x;
+  x *= 2 - n * x;
+  return 0 - x;
+}
+
+/* a * b * 2^-32 mod n for a, b < n < 2^31. The low word of
+ * t + m*n is always zero, so only its carry is needed. */
+static unsigned mont_mul(unsigned a, unsigned b, unsigned n, unsigned ninv)
+{
+  unsigned long long t = (unsigned long long) a * b;
+  unsigned lo = (unsigned) t;
+  unsigned m = lo * ninv;
+  unsigned r = (unsigned) (t >> 32)
+             + (unsigned) (((unsigned long long) m * n) >> 32)
+             + (lo != 0);
+  return r >= n ? r - n : r;
+}
+
+/* x * k mod n for small k, by shift-and-add (x < n < 2^31). */
+static unsigned mod_mul_small(unsigned x, unsigned k, unsigned n)
+{
+  unsigned r = 0;
+  while (k != 0) {
+    if (k & 1) {
+      r += x;
+      if (r >= n) r -= n;
+    }
+    x <<= 1;
+    if (x >= n) x -= n;
+    k >>= 1;
+  }
+  return r;
+}
+
+/* One Miller-Rabin round. one = 2^32 mod n is 1 in Montgomery form. */
+static int mr_witness_passes(unsigned n, unsigned ninv, unsigned one,
+                             unsigned d, int s, unsigned base)
+{
+  unsigned minus_one = n - one;
+  unsigned b = mod_mul_small(one, base, n);
+  unsigned x = one;
+
+  for (;;) {
+    if (d & 1)
+      x = mont_mul(x, b, n, ninv);
+    d >>= 1;
+    if (d == 0)
+      break;
+    b = mont_mul(b, b, n, ninv);
+  }
+  if (x == one || x == minus_one)
+    return PRIME_TRUE;
+  while (--s > 0) {
+    x = mont_mul(x, x, n, ninv);
+    if (x == minus_one)
+      return PRIME_TRUE;
+  }
+  return PRIME_FALSE;
+}
+
+/* Primality of an odd n < 2^31. */
+static int is_prime_odd(unsigned n)
+{
+  unsigned ninv, one, d;
+  unsigned i;
+  int s;
+
+  if (n < 64)
+    return ((n < 32 ? SMALL_PRIMES_LO >> n : SMALL_PRIMES_HI >> (n - 32)) & 1);
+
+  for (i = 0; i < SMALL_PRIME_COUNT; i++)
+    if (n * small_prime_filter[i][0] <= small_prime_filter[i][1])
+      return PRIME_FALSE;
+  if (n < SMALL_PRIME_SQUARE)
+    return PRIME_TRUE;
+
+  ninv = mont_ninv(n);
+  one = (0u - n) % n;
+  d = n - 1;
+  for (s = 0; (d & 1) == 0; s++)
+    d >>= 1;
+
+  return mr_witness_passes(n, ninv, one, d, s, 2)
+      && mr_witness_passes(n, ninv, one, d, s, 7)
+      && mr_witness_passes(n, ninv, one, d, s, 61);
+}
+
 int nextprime( int inval )
+{
+   unsigned perhapsprime;   /* Holds a tentative prime while we check it. */
+
+   if (inval < 3 )          /* Initial sanity check of parameter. */
+   {
+     if(inval <= 0) return(1);  /* Return 1 for zero or negative input. */
+     if(inval == 1) return(2);  /* Easy special case. */
+     return(3);                 /* inval == 2 */
+   }
+   /* Testing an even number for primeness is pointless, since
+    * all even numbers are divisible by 2. Therefore, we make sure
+    * that perhapsprime is larger than the parameter, and odd. */
+   perhapsprime = ( (unsigned) inval + 1 ) | 1 ;
+   while (!is_prime_odd(perhapsprime))
+     perhapsprime += 2;
+   return( (int) perhapsprime );
+}
+
+#ifdef PRIME_BENCH
+#include "dtekv-csr.h"
+
+/*
+ * nextprime_trial
+ *
+ * The original trial-division routine, kept only as the baseline
+ * for bench_nextprime().
+ */
+static int nextprime_trial( int inval )
 {
    register int perhapsprime = 0; /* Holds a tentative prime while we check it. */
    register int testfactor; /* Holds various factors for which we test perhapsprime. */
@@ -98,29 +267,58 @@ int nextprime( int inval )
    }
    else
    {
-     /* Testing an even number for primeness is pointless, since
-      * all even numbers are divisible by 2. Therefore, we make sure
-      * that perhapsprime is larger than the parameter, and odd. */
      perhapsprime = ( inval + 1 ) | 1 ;
    }
-   /* While prime not found, loop. */
    for( found = PRIME_FALSE; found != PRIME_TRUE; perhapsprime += 2 )
    {
-     /* Check factors from 3 up to perhapsprime/2. */
      for( testfactor = 3; testfactor <= (perhapsprime >> 1) + 1; testfactor += 1 )
      {
-       found = PRIME_TRUE;      /* Assume we will find a prime. */
-       if( (perhapsprime % testfactor) == 0 ) /* If testfactor divides perhapsprime... */
+       found = PRIME_TRUE;
+       if( (perhapsprime % testfactor) == 0 )
        {
-         found = PRIME_FALSE;   /* ...then, perhapsprime was non-prime. */
-         goto check_next_prime; /* Break the inner loop, go test a new perhapsprime. */
+         found = PRIME_FALSE;
+         goto check_next_prime;
        }
      }
-     check_next_prime:;         /* This label is used to break the inner loop. */
-     if( found == PRIME_TRUE )  /* If the loop ended normally, we found a prime. */
+     check_next_prime:;
+     if( found == PRIME_TRUE )
      {
-       return( perhapsprime );  /* Return the prime we found. */
+       return( perhapsprime );
      } 
    }
-   return( perhapsprime );      /* When the loop ends, perhapsprime is a real prime. */
-} 
+   return( perhapsprime );
+}
+
+static void bench_one(char *name, int (*fn)(int), int inval)
+{
+  unsigned long long c0, c1;
+  int p;
+
+  c0 = read_mcycle();
+  p = fn(inval);
+  c1 = read_mcycle();
+
+  print(name); print(" nextprime("); print_dec(inval);
+  print(") = "); print_dec(p);
+  print(" cycles="); print_dec64(c1 - c0);
+  printc('\n');
+}
+
+/*
+ * bench_nextprime
+ *
+ * Cycle counts for the Miller-Rabin engine and the old trial-division
+ * routine. The engine runs first on every input because the old
+ * routine needs on the order of 10^10 cycles near 2^31.
+ */
+void bench_nextprime(void)
+{
+  static const int inputs[] = { 1234567, 2147483000, 2147483600 };
+  unsigned i;
+
+  for (i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+    bench_one("[mr]   ", nextprime, inputs[i]);
+  for (i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+    bench_one("[trial]", nextprime_trial, inputs[i]);
+}
+#endif
@@ -0,0 +1,61 @@
+/* heap.h
+
+   Allocation from the heap the linker script reserves between
+   __heap_start and __heap_end (__heap_size bytes, 16 KB unless the
+   link overrides it; the sieve tables take about 10 KB of it). Nothing is ever returned to the heap itself;
+   it is carved once, at init time, into the two allocators below.
+
+   Arena: a bump allocator for scratch memory that lives for one pass
+   of a loop or one frame. arena_alloc() is a pointer increment and
+   arena_reset() frees everything at once; arena_mark() and
+   arena_release() free back to a saved point.
+
+   Pool: fixed-size blocks on a free list, for event and message
+   objects. pool_alloc() and pool_free() are O(1) and may be called
+   from interrupt handlers. The core has no atomics, so both run with
+   mstatus.MIE clear for a handful of instructions instead.
+
+   heap_dump() prints the heap, every arena and every pool with its
+   high-water mark. */
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#define HEAP_ALIGN 8
+
+struct arena {
+  const char *name;
+  char *base, *cur, *end;
+  unsigned high;                        /* Most bytes in use at once. */
+  struct arena *next;
+};
+
+struct pool {
+  const char *name;
+  void *free;
+  unsigned block, count;
+  unsigned used, high;
+  struct pool *next;
+};
+
+/* Take size bytes for good; 0 when the heap is exhausted. */
+void *heap_carve(unsigned size);
+unsigned heap_used(void);
+unsigned heap_size(void);
+
+/* Both return 0 on success, -1 when the heap is too small (or, for
+   pool_init, when count is 0). */
+int arena_init(struct arena *a, const char *name, unsigned size);
+int pool_init(struct pool *p, const char *name, unsigned block, unsigned count);
+
+void *arena_alloc(struct arena *a, unsigned size);   /* 0 when full. */
+static inline void *arena_mark(struct arena *a) { return a->cur; }
+static inline void arena_release(struct arena *a, void *mark) { a->cur = mark; }
+static inline void arena_reset(struct arena *a) { a->cur = a->base; }
+
+void *pool_alloc(struct pool *p);                     /* 0 when empty. */
+void pool_free(struct pool *p, void *block);
+
+void heap_dump(void);
+
+#endif
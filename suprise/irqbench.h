@@ -0,0 +1,26 @@
+/* irqbench.h
+
+   Timer interrupt latency and throughput benchmark.
+
+   irqbench_run() takes over the interval timer and, for a sweep of
+   timer periods starting at 3,000,000 cycles, measures how long it
+   takes from the timeout to the handler reading the timer snapshot.
+   It runs once with an idle main loop and once with the prime
+   iterator as background load, and reports one line per step:
+
+     IRQBENCH load=idle period=3000000 samples=16 lost=0 min=.. p50=.. p99=.. max=..
+
+   followed by the highest sustainable rate for each load:
+
+     IRQBENCH_MAX load=idle period=.. hz=..
+
+   All latencies are in cycles. The timer and the timer interrupt
+   handler are restored to their defaults when it returns, so call it
+   before labinit(). */
+
+#ifndef IRQBENCH_H
+#define IRQBENCH_H
+
+void irqbench_run(void);
+
+#endif
@@ -1,4 +1,20 @@
 #include <stdio.h>
+#include "sieve.h"
+#include "clock.h"
+#include "console.h"
+#include "delay.h"
+#include "display.h"
+#include "dtekv-hw.h"
+#include "fixed.h"
+#include "input.h"
+#include "meter.h"
+#include "prof.h"
+#include "stack.h"
+#include "startup.h"
+#include "sync.h"
+#include "tickless.h"
+#include "trap.h"
+#include "irqbench.h"
 
 /* main.c
 
@@ -15,6 +31,7 @@ extern void time2string(char*,int);
 extern void tick(int*);
 extern void delay(int);
 extern int nextprime( int );
+extern void bench_nextprime(void);
 extern void enable_interrupt(void); // added
 
 int mytime = 0x5957;
@@ -28,146 +45,214 @@ int prime = 1234567;
 int hours = 0;
 int minutes = 0;
 int seconds = 0;
-char textbuffer[30];   // Buffer for time2string
 
-// Interrupt Cause Constants
-#define CAUSE_MACHINE_EXTERNAL 11
+// hours, minutes, seconds and mytime are written by the timer interrupt,
+// the time also by handle_input (with interrupts off); update_outputs,
+// which runs in both, takes a consistent copy with
+// SEQ_READ(&clock_lock, ...) instead of masking interrupts (sync.h)
+struct seqlock clock_lock;
+
+// Profiler regions (build with CPPFLAGS=-DPROF_ENABLE); update_outputs
+// runs in the timer interrupt and in main, so each side has its own id
+enum { PROF_IRQ, PROF_TICK, PROF_TIME2STRING, PROF_TIME2STRING_MAIN, PROF_PRIME };
 
 // Helper function to read Switches
 int get_sw(void) {
-    volatile int *sw_ptr = (volatile int *)0x04000010;
-    return *sw_ptr & 0x3FF;
+    return hw_switches();
 }
 
 // Helper function to read Button (Bit 1)
 int get_btn(void) {
-    volatile int *btn_ptr = (volatile int *)0x040000d0;
-    return *btn_ptr & 1; 
+    return hw_buttons() & 1;
 }
 
 void set_displays(int display_number, int value) {
-    static const int hex_codes[] = {
-        0xC0, 0xF9, 0xA4, 0xB0, 0x99, 
-        0x92, 0x82, 0xF8, 0x80, 0x90
-    };
-    volatile int *display_ptr = (volatile int *)(0x04000050 + (display_number * 0x10));
-    if (value >= 0 && value <= 9) {
-        *display_ptr = hex_codes[value];
-    } else {
-        *display_ptr = 0xFF;
+    display_digit(display_number, value);
+    display_flush();
+}
+
+/* Refresh the text clock and the 7-segment displays after a change.
+ * Called from the timer interrupt and, with interrupts on, from
+ * handle_input (prof is the caller's profiler id): only the display
+ * update masks interrupts, never the console output. */
+static void update_outputs(int prof) {
+    char text[8];  // Not shared: the interrupt may run this meanwhile
+    int h, m, s;
+
+    PROF_BEGIN(prof);
+    time2string(text, READ_ONCE(mytime));
+    PROF_END(prof);
+    display_string(text);
+
+    // Only the digits that changed reach the hardware, unless the
+    // meter has them (CPPFLAGS=-DPRIME_METER, see meter.h). The
+    // display shadow is shared with the interrupt: a short section.
+    SEQ_READ(&clock_lock, h = hours; m = minutes; s = seconds);
+    CRITICAL_BEGIN();
+    if (!meter_show(get_sw())) {
+        display_clock(h, m, s);
+        display_flush();
     }
+    CRITICAL_END();
 }
 
-/* * INTERRUPT HANDLER 
- * The assembly code calls this function with the 'cause' argument.
+static void advance_second(void) {
+    SEQ_WRITE(&clock_lock, clock_add_seconds(&hours, &minutes, &seconds, 1));
+    meter_second();
+}
+
+/* mytime advances ten times a second from the timer, never on a
+ * button press. */
+static void advance_tick(int n) {
+    PROF_BEGIN(PROF_TICK);
+    seq_write_begin(&clock_lock);
+    while (n-- > 0)
+        tick(&mytime);
+    seq_write_end(&clock_lock);
+    PROF_END(PROF_TICK);
+}
+
+/* * TIMER INTERRUPT (cause 16, registered in labinit)
  */
-void handle_interrupt(unsigned cause) {
-    volatile int *timer_status = (volatile int *)(0x04000020);
-    volatile int *btn_edge     = (volatile int *)(0x040000dc);
-    
-    // Debug Print (Uncomment if needed)
-    if (cause != 16) { 
-        print("Cause: "); print_dec(cause); print("\n"); 
-    }
+void timer_interrupt(unsigned cause) {
+    PROF_BEGIN(PROF_IRQ);
 
-    // ==========================================
-    // 1. CHECK TIMER (Address 0x04000020)
-    // ==========================================
-    if (cause == 16) {
-        if ((*timer_status & 1) == 1) {
-            *timer_status = 0; 
-            timeoutcount++;
-
-            if (timeoutcount >= 10) {
-                timeoutcount = 0;
-                seconds++;
-                if (seconds >= 60) {
-                    seconds = 0;
-                    minutes++;
-                    if (minutes >= 60) {
-                        minutes = 0;
-                        hours++;
-                        if (hours >= 24) hours = 0;
-                    }
-                }
-            }
+    if (hw_timer_timeout()) {
+        hw_timer_ack();
+        timeoutcount++;
+
+        if (timeoutcount >= 10) {
+            timeoutcount = 0;
+            advance_second();
         }
     }
+    advance_tick(1);
+    update_outputs(PROF_TIME2STRING);
+
+    PROF_END(PROF_IRQ);
+}
 
-    // ==========================================
-    // 2. CHECK BUTTON (Address 0x040000dc)
-    // ==========================================
-    if (cause == 18) {
-        *btn_edge = 0;
-
-        if (get_btn()) {
-            // A. Acknowledge IMMEDIATELY.
-            // We write 1s to all bits. This is critical to stop the interrupt line.
-
-            // B. Increment Logic
-            // Since Cause 18 fired, we know a button was pressed.
-            // We skip checking specific bits because the register read was unreliable (returned 0).
-            seconds += 2;
-            if (seconds >= 60) {
-                seconds -= 60; 
-                minutes++;
-                if (minutes >= 60) {
-                    minutes = 0;
-                    hours++;
-                    if (hours >= 24) hours = 0;
-                }
-            }
+#ifdef TICKLESS
+/* * ONE-SECOND DEADLINE (tickless.c arms the timer for it)
+ */
+static void tickless_second(void) {
+    PROF_BEGIN(PROF_IRQ);
+    advance_second();
+    advance_tick(10);  // the ten 100 ms ticks of the second at once
+    update_outputs(PROF_TIME2STRING);
+    PROF_END(PROF_IRQ);
+}
+#endif
+
+/* * BUTTON PRESSES
+ * The button interrupt now only queues debounced events (input.c);
+ * they are drained here, from the main loop, in batches.
+ */
+static void handle_input(void) {
+    struct input_event ev[8];
+    int i, n;
+
+    while ((n = input_read(ev, 8)) > 0) {
+        for (i = 0; i < n; i++) {
+            // Button 0 going down adds two seconds
+            if (ev[i].source != INPUT_BUTTONS || ev[i].bit != 0 || !(ev[i].state & 1))
+                continue;
+
+            // The timer interrupt updates the same time: mask it for
+            // the update only, not for the console output after it
+            SEQ_WRITE_IRQ(&clock_lock,
+                          clock_add_seconds(&hours, &minutes, &seconds, 2));
+            update_outputs(PROF_TIME2STRING_MAIN);
         }
     }
+}
 
-    // ==========================================
-    // 3. UPDATE DISPLAYS
-    // ==========================================
-    tick(&mytime);
-    time2string(textbuffer, mytime);
-    display_string(textbuffer);
-
-    set_displays(0, seconds % 10);
-    set_displays(1, seconds / 10);
-    set_displays(2, minutes % 10);
-    set_displays(3, minutes / 10);
-    set_displays(4, hours % 10);
-    set_displays(5, hours / 10);
+/* * INTERRUPT HANDLER 
+ * Fallback for every cause without its own handler (see trap.c).
+ */
+void handle_interrupt(unsigned cause) {
+    print("Cause: "); print_dec(cause); print("\n"); 
 }
 
 /* Initialize Interrupts and Timer */
 void labinit(void) {
-    // Timer Pointers
-    volatile int *timer_periodl = (volatile int *)(0x04000020 + 0x8);
-    volatile int *timer_periodh = (volatile int *)(0x04000020 + 0xC);
-    volatile int *timer_control = (volatile int *)(0x04000020 + 0x4);
-    volatile int *timer_status  = (volatile int *)(0x04000020);
+#ifndef TICKLESS
+    // 1. Setup Timer Hardware (100ms)
+    hw_timer_start(3000000, TIMER_CONT | TIMER_ITO);
+#endif
 
-    // Button Pointers
-    volatile int *btn_mask = (volatile int *)(0x040000d0 + 0x8); 
-    volatile int *btn_edge = (volatile int *)(0x040000d0 + 0xC);
+    // 2. Button and switch edge interrupts feed the input queue
+    input_init();
 
-    // 1. Setup Timer Hardware (100ms)
-    *timer_periodl = 0xC6C0; 
-    *timer_periodh = 0x002D; 
-    *timer_control = 0x7;    // Start (1) + Cont (2) + ITO (4) = 7.
-    *timer_status = 0;
-
-    // 2. Setup Button Hardware
-    // Enable interrupts for ALL 4 buttons (0xF = 1111)
-    // This ensures we catch the click even if you press Button 0 or Button 1.
-    *btn_mask = 1;   
-    
-    // Clear any previous edges to prevent immediate interrupt on start
-    //*btn_edge = 0xF; 
+    // 3. One handler per cause; boot.S dispatches straight to them.
+#ifdef TICKLESS
+    // Build with CPPFLAGS=-DTICKLESS: one timer interrupt per second
+    tickless_start(tickless_second);
+#else
+    irq_register(IRQ_TIMER, timer_interrupt);
+#endif
+#ifdef CONSOLE_IRQ
+    // Build with CPPFLAGS=-DCONSOLE_IRQ=n: the JTAG UART write
+    // interrupt on line n drains the console (see console.h)
+    irq_register(CONSOLE_IRQ, console_irq);
+    irq_enable(CONSOLE_IRQ);
+    console_use_irq(1);
+#endif
 
     enable_interrupt();
+    startup_clock_started();
 }
 
 int main() {
+#ifdef DELAY_BENCH
+    delay_init();  // 10 ms calibration, before anything starts the timer
+    delay_selftest();
+#endif
+#ifdef PRIME_BENCH
+    bench_nextprime();
+#endif
+#ifdef IRQ_BENCH
+    irqbench_run();
+#endif
+#ifdef FIXED_BENCH
+    fixed_bench();
+#endif
+    PROF_NAME(PROF_IRQ, "irq");
+    PROF_NAME(PROF_TICK, "tick");
+    PROF_NAME(PROF_TIME2STRING, "time2string");
+    PROF_NAME(PROF_TIME2STRING_MAIN, "time2string main");
+    PROF_NAME(PROF_PRIME, "prime");
+#ifdef PROF_ENABLE
+    int dumped_minute = minutes;
+#endif
+#ifdef STACK_PAINT
+    int stack_minute = minutes;
+#endif
     labinit();
+#ifdef BOOT_BANNER
+    startup_banner();
+#endif
+    prime_iter_init(prime);
 
     while (1) {
-        prime = nextprime(prime);
+        PROF_BEGIN(PROF_PRIME);
+        prime = prime_iter_next();
+        PROF_END(PROF_PRIME);
+        meter_prime(prime);
+        handle_input();
+        meter_poll();
+        console_poll();  // drain what handle_interrupt queued
+#ifdef PROF_ENABLE
+        if (minutes != dumped_minute) {  // once a minute
+            dumped_minute = minutes;
+            prof_dump();
+        }
+#endif
+#ifdef STACK_PAINT
+        if (minutes != stack_minute) {  // once a minute
+            stack_minute = minutes;
+            stack_report();
+        }
+#endif
     }
 }
\ No newline at end of file
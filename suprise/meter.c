@@ -0,0 +1,101 @@
+/* meter.c
+
+   The sample is written in timer context and read by meter_poll() in
+   the main loop under a sequence lock, so printing never holds off
+   the interrupts it is measuring. Candidates are
+   not counted one by one: every odd number between two consecutive
+   primes was passed over, so the count is half the distance the last
+   prime moved. */
+
+#include "meter.h"
+
+#ifdef PRIME_METER
+
+#include "console.h"
+#include "display.h"
+#include "dtekv-csr.h"
+#include "dtekv-hw.h"
+#include "fmt.h"
+#include "sync.h"
+
+#define LED_COUNT 10
+
+volatile unsigned meter_primes;
+volatile unsigned meter_last;
+
+struct sample {
+  unsigned primes;                      /* Primes found in the second. */
+  unsigned candidates;                  /* Odd numbers passed over. */
+  unsigned cycles;                      /* mcycle per prime. */
+  unsigned peak;                        /* Best primes/s so far. */
+};
+
+static struct sample sample;
+static unsigned samples;                /* Bumped per sample. */
+static struct seqlock sample_lock;      /* Over sample and samples. */
+static unsigned printed;
+static unsigned prev_primes, prev_last, prev_cycle;
+static int started;
+static unsigned leds;
+
+void meter_second(void)
+{
+  unsigned primes = meter_primes, last = meter_last;
+  unsigned cycle = (unsigned) read_mcycle();
+  unsigned n = primes - prev_primes;
+
+  /* The first call only sets the baseline. */
+  if (started) {
+    seq_write_begin(&sample_lock);
+    sample.primes = n;
+    sample.candidates = (last - prev_last) >> 1;
+    sample.cycles = n ? (cycle - prev_cycle) / n : 0;
+    if (n > sample.peak)
+      sample.peak = n;
+    samples++;
+    seq_write_end(&sample_lock);
+  }
+  started = 1;
+  prev_primes = primes;
+  prev_last = last;
+  prev_cycle = cycle;
+}
+
+int meter_show(unsigned switches)
+{
+  unsigned lit = 0;
+
+  if ((switches & METER_SW_LEDS) && sample.peak)
+    lit = (1u << (sample.primes * LED_COUNT / sample.peak)) - 1;
+  if (lit != leds) {
+    leds = lit;
+    hw_leds(lit);
+  }
+
+  if (switches & METER_SW_HEX) {
+    unsigned v = sample.primes > 999999 ? 999999 : sample.primes;
+    int i;
+
+    for (i = 0; i < DISPLAY_DIGITS; i++) {
+      display_digit(i, v || i == 0 ? (int) (v % 10) : -1);
+      v /= 10;
+    }
+    display_flush();
+    return 1;
+  }
+  return 0;
+}
+
+void meter_poll(void)
+{
+  struct sample s;
+  char line[80];
+
+  if (READ_ONCE(samples) == printed)
+    return;
+  SEQ_READ(&sample_lock, s = sample; printed = samples);
+  console_write(line, fmt(line, "METER primes/s=%u cand/s=%u cycles/prime=%u peak=%u\n",
+                          s.primes, s.candidates, s.cycles, s.peak));
+}
+
+#endif
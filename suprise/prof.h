@@ -0,0 +1,80 @@
+/* prof.h
+
+   Region profiler on the mcycle and minstret counters.
+
+     PROF_NAME(PROF_TICK, "tick");
+     PROF_BEGIN(PROF_TICK);
+     tick(&mytime);
+     PROF_END(PROF_TICK);
+     ...
+     prof_dump();
+
+   Each region keeps count, min, max and sum of cycles plus the sum of
+   retired instructions. Regions are numbered 0..PROF_MAX_REGIONS-1;
+   a region must not be re-entered before it ends, so give interrupt
+   handlers their own ids.
+
+   Build with -DPROF_ENABLE (make CPPFLAGS=-DPROF_ENABLE) to turn it
+   on. Without it every macro expands to nothing and prof_dump() is an
+   empty inline, so instrumented code can stay in release builds. */
+
+#ifndef PROF_H
+#define PROF_H
+
+#define PROF_MAX_REGIONS 16
+
+#ifdef PROF_ENABLE
+
+#include "dtekv-csr.h"
+
+struct prof_region {
+  const char *name;
+  unsigned long long t0, i0;          /* Counters at PROF_BEGIN. */
+  unsigned long long sum, insns;
+  unsigned long long min, max;
+  unsigned count;
+};
+
+extern struct prof_region prof_regions[PROF_MAX_REGIONS];
+
+static inline void prof_begin(int id)
+{
+  prof_regions[id].i0 = read_minstret();
+  prof_regions[id].t0 = read_mcycle();
+}
+
+static inline void prof_end(int id)
+{
+  unsigned long long t1 = read_mcycle();
+  unsigned long long i1 = read_minstret();
+  struct prof_region *r = &prof_regions[id];
+  unsigned long long dt = t1 - r->t0;
+
+  if (r->count == 0 || dt < r->min)
+    r->min = dt;
+  if (dt > r->max)
+    r->max = dt;
+  r->sum += dt;
+  r->insns += i1 - r->i0;
+  r->count++;
+}
+
+#define PROF_NAME(id, str)  (prof_regions[id].name = (str))
+#define PROF_BEGIN(id)      prof_begin(id)
+#define PROF_END(id)        prof_end(id)
+
+void prof_dump(void);
+void prof_reset(void);
+
+#else
+
+#define PROF_NAME(id, str)  ((void) 0)
+#define PROF_BEGIN(id)      ((void) 0)
+#define PROF_END(id)        ((void) 0)
+
+static inline void prof_dump(void) {}
+static inline void prof_reset(void) {}
+
+#endif
+
+#endif
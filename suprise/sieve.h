@@ -0,0 +1,17 @@
+/* sieve.h
+
+   Resumable prime iterator backed by a segmented, odd-only sieve.
+   Its two tables, about 10 KB, are taken from the heap (heap.h) by
+   the first prime_iter_init() and kept for good. */
+
+#ifndef SIEVE_H
+#define SIEVE_H
+
+/* Restart the iterator so that the next prime returned is the first
+   prime larger than start. Valid for 0 <= start < 2147483647. */
+void prime_iter_init(int start);
+
+/* Return the next prime in increasing order. */
+int prime_iter_next(void);
+
+#endif
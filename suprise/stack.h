@@ -0,0 +1,34 @@
+/* stack.h
+
+   Stack high-water measurement.
+
+   Build with CPPFLAGS=-DSTACK_PAINT and _start fills the whole stack,
+   _stack_begin to _stack_end, with STACK_PAINT_WORD before calling
+   main. stack_high_water() then finds the lowest word that no longer
+   holds the pattern: the deepest the stack has been since boot.
+   Without STACK_PAINT it returns 0.
+
+   The static side comes from the build: the Makefile compiles with
+   -fstack-usage and sorts the per-function frame sizes into
+   main.stack.txt. */
+
+#ifndef STACK_H
+#define STACK_H
+
+#define STACK_PAINT_WORD 0x5AFE5AFE
+
+#ifndef __ASSEMBLER__
+
+/* Deepest stack use since boot, in bytes. */
+unsigned stack_high_water(void);
+
+/* Bytes never touched in the painted range [lo, hi), counted up
+   from lo; for stacks carved out of the painted area. */
+unsigned stack_unused(const void *lo, const void *hi);
+
+/* Print the high-water mark and the stack size. */
+void stack_report(void);
+
+#endif
+
+#endif
@@ -0,0 +1,45 @@
+/* startup.c */
+
+#include "startup.h"
+#include "console.h"
+#include "dtekv-csr.h"
+#include "fmt.h"
+
+static const char banner[] =
+  "================================================\n"
+  "===== RISC-V Boot-Up Process Now Complete ======\n"
+  "================================================\n";
+
+static unsigned long long boot_clock_cycles;
+
+unsigned startup_cycles(void)
+{
+  return (unsigned) (boot_main_cycles - boot_reset_cycles);
+}
+
+void startup_clock_started(void)
+{
+  if (boot_clock_cycles == 0)
+    boot_clock_cycles = read_mcycle();
+}
+
+unsigned startup_clock_cycles(void)
+{
+  if (boot_clock_cycles == 0)
+    return 0;
+  return (unsigned) (boot_clock_cycles - boot_reset_cycles);
+}
+
+void startup_banner(void)
+{
+  char line[48];
+  unsigned clock = startup_clock_cycles();
+
+  console_write(banner, sizeof banner - 1);
+  console_write(line, fmt(line, "BOOT reset->main %u cycles\n",
+                          startup_cycles()));
+  if (clock != 0)
+    console_write(line, fmt(line, "BOOT reset->clock %u cycles = %u us\n",
+                            clock, clock / 30));      /* 30 MHz */
+  console_flush();
+}
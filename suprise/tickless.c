@@ -0,0 +1,103 @@
+/* tickless.c
+
+   next_second and the timeout deadlines are absolute mcycle values.
+   The interrupt handler runs everything that is due, then arms the
+   timer for the nearest deadline left. */
+
+#include "tickless.h"
+#include "dtekv-csr.h"
+#include "dtekv-hw.h"
+#include "sync.h"
+#include "trap.h"
+
+#define MIN_ARM 64u                     /* Don't arm for less than this. */
+
+struct timeout {
+  unsigned long long due;
+  tickless_fn fn;                       /* Null when the slot is free. */
+};
+
+static struct timeout timeouts[TICKLESS_TIMEOUTS];
+static unsigned long long next_second;
+static unsigned long long armed_for;
+static tickless_fn second_fn;
+
+/* Arm the one-shot timer for the nearest deadline. Interrupts off. */
+static void arm(unsigned long long now)
+{
+  unsigned long long next = next_second;
+  unsigned long long delta;
+  int i;
+
+  for (i = 0; i < TICKLESS_TIMEOUTS; i++)
+    if (timeouts[i].fn && timeouts[i].due < next)
+      next = timeouts[i].due;
+
+  delta = next > now ? next - now : 0;
+  if (delta < MIN_ARM)
+    delta = MIN_ARM;
+  armed_for = now + delta;
+  hw_timer_start((unsigned) delta - 1, TIMER_ITO);
+}
+
+static void tickless_interrupt(unsigned cause)
+{
+  unsigned long long now;
+  int i;
+
+  hw_timer_ack();
+  now = read_mcycle();
+
+  while (now >= next_second) {
+    next_second += TICKLESS_HZ;
+    second_fn();
+  }
+  for (i = 0; i < TICKLESS_TIMEOUTS; i++) {
+    tickless_fn fn = timeouts[i].fn;
+    if (fn && timeouts[i].due <= now) {
+      timeouts[i].fn = 0;
+      fn();
+    }
+  }
+  arm(read_mcycle());
+}
+
+void tickless_start(tickless_fn on_second)
+{
+  unsigned flags = irq_save();
+  unsigned long long now = read_mcycle();
+
+  second_fn = on_second;
+  next_second = now + TICKLESS_HZ;
+  irq_register(IRQ_TIMER, tickless_interrupt);
+  arm(now);
+  irq_enable(IRQ_TIMER);
+  irq_restore(flags);
+}
+
+int tickless_after(unsigned cycles, tickless_fn fn)
+{
+  unsigned flags = irq_save();
+  unsigned long long now = read_mcycle();
+  int i;
+
+  for (i = 0; i < TICKLESS_TIMEOUTS; i++)
+    if (timeouts[i].fn == 0)
+      break;
+  if (i == TICKLESS_TIMEOUTS) {
+    irq_restore(flags);
+    return -1;
+  }
+  timeouts[i].due = now + cycles;
+  timeouts[i].fn = fn;
+  if (timeouts[i].due < armed_for)
+    arm(now);
+  irq_restore(flags);
+  return i;
+}
+
+void tickless_cancel(int slot)
+{
+  if ((unsigned) slot < TICKLESS_TIMEOUTS)
+    timeouts[slot].fn = 0;
+}
@@ -0,0 +1,34 @@
+/* trap.c
+
+   Handler tables read by the trap entry in boot.S. */
+
+#include "trap.h"
+#include "dtekv-lib.h"
+
+extern void handle_interrupt(unsigned cause);
+
+#define DEFAULT_IRQ4 handle_interrupt, handle_interrupt, handle_interrupt, handle_interrupt
+#define DEFAULT_EXC4 handle_exception, handle_exception, handle_exception, handle_exception
+
+irq_handler_t irq_table[32] = {
+  DEFAULT_IRQ4, DEFAULT_IRQ4, DEFAULT_IRQ4, DEFAULT_IRQ4,
+  DEFAULT_IRQ4, DEFAULT_IRQ4, DEFAULT_IRQ4, DEFAULT_IRQ4
+};
+
+exc_handler_t exc_table[16] = {
+  DEFAULT_EXC4, DEFAULT_EXC4, DEFAULT_EXC4, DEFAULT_EXC4
+};
+
+/* Each table slot is one aligned word, so the entry code never sees a
+   half-written pointer even if an interrupt lands mid-update. */
+void irq_register(unsigned cause, irq_handler_t fn)
+{
+  if (cause < 32)
+    irq_table[cause] = fn ? fn : handle_interrupt;
+}
+
+void exc_register(unsigned cause, exc_handler_t fn)
+{
+  if (cause < 16)
+    exc_table[cause] = fn ? fn : handle_exception;
+}
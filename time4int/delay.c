@@ -0,0 +1,124 @@
+/* delay.c
+
+   Calibration counts mcycle across 10 ms of timer clock, read through
+   the snapshot registers. Each snapshot is followed by an mcycle read
+   in the same order, so the read latency cancels out.
+
+   Conversions use multiply and shift only: cycles per microsecond is
+   kept in 16.16 fixed point, which holds clocks up to 65 MHz. */
+
+#include "delay.h"
+#include "dtekv-csr.h"
+#include "dtekv-hw.h"
+#include "trap.h"
+
+#define CAL_TICKS 300000u               /* 10 ms at the nominal clock */
+
+static unsigned cycles_per_ms = DELAY_NOMINAL_HZ / 1000;
+static unsigned cycles_per_us_q16 = ((DELAY_NOMINAL_HZ / 1000) << 16) / 1000;
+
+void delay_init(void)
+{
+  unsigned s0, s1, ticks, cycles, cpm;
+  unsigned long long c0;
+
+  if (HW_READ(HW_TIMER->status) & TIMER_RUN)
+    return;                             /* Someone else's timer. */
+
+  hw_timer_start(0xffffffff, 0);        /* One-shot, no interrupt. */
+  s0 = hw_timer_snapshot();
+  c0 = read_mcycle();
+  do
+    s1 = hw_timer_snapshot();
+  while (s0 - s1 < CAL_TICKS);
+  cycles = (unsigned) (read_mcycle() - c0);
+  hw_timer_stop();
+  hw_timer_ack();
+
+  /* cycles * 30000 / ticks, with ticks only just above CAL_TICKS. */
+  ticks = s0 - s1;
+  cpm = cycles / 10;
+  cpm -= cpm * (ticks - CAL_TICKS) / ticks;
+  if (cpm == 0 || cpm >= 65536)
+    return;
+  cycles_per_ms = cpm;
+  cycles_per_us_q16 = (cpm << 16) / 1000;
+}
+
+unsigned delay_cycles_per_ms(void)
+{
+  return cycles_per_ms;
+}
+
+/* wfi is only safe if the timer interrupt will end it in time. */
+static int timer_can_wake(void)
+{
+  unsigned mie;
+
+  __asm__ volatile ("csrr %0, mie" : "=r"(mie));
+  return (mie & (1u << IRQ_TIMER)) &&
+         (HW_READ(HW_TIMER->control) & TIMER_ITO) &&
+         (HW_READ(HW_TIMER->status) & TIMER_RUN);
+}
+
+static void wait_cycles(unsigned long long n)
+{
+  unsigned long long end = read_mcycle() + n;
+  int sleep = n > (unsigned long long) DELAY_WFI_MS * cycles_per_ms &&
+              timer_can_wake();
+  long long left;
+
+  while ((left = (long long) (end - read_mcycle())) > 0) {
+    /* Sleep only if the next timeout lands before the deadline. */
+    if (sleep && hw_timer_snapshot() < (unsigned long long) left)
+      __asm__ volatile ("wfi");
+  }
+}
+
+void delay_us(unsigned us)
+{
+  wait_cycles(((unsigned long long) us * cycles_per_us_q16) >> 16);
+}
+
+void delay_ms(unsigned ms)
+{
+  wait_cycles((unsigned long long) ms * cycles_per_ms);
+}
+
+#ifdef DELAY_BENCH
+#include "console.h"
+#include "fmt.h"
+
+static void report(const char *unit, unsigned n, unsigned target,
+                   unsigned actual)
+{
+  char line[80];
+
+  console_write(line, fmt(line, "DELAY %s=%u target=%u actual=%u err=%d\n",
+                          unit, n, target, actual, (int) (actual - target)));
+  console_flush();
+}
+
+void delay_selftest(void)
+{
+  static const unsigned us[] = { 1, 10, 100, 1000, 10000 };
+  static const unsigned ms[] = { 1, 10, 100, 1000 };
+  char line[48];
+  unsigned long long t0;
+  unsigned i;
+
+  console_write(line, fmt(line, "DELAY cycles_per_ms=%u\n", cycles_per_ms));
+  for (i = 0; i < sizeof us / sizeof us[0]; i++) {
+    t0 = read_mcycle();
+    delay_us(us[i]);
+    report("us", us[i], us[i] * cycles_per_ms / 1000,
+           (unsigned) (read_mcycle() - t0));
+  }
+  for (i = 0; i < sizeof ms / sizeof ms[0]; i++) {
+    t0 = read_mcycle();
+    delay_ms(ms[i]);
+    report("ms", ms[i], ms[i] * cycles_per_ms,
+           (unsigned) (read_mcycle() - t0));
+  }
+}
+#endif
@@ -0,0 +1,37 @@
+/* display.h
+
+   Shadow framebuffer for the six 7-segment digits.
+
+   The setters only update the shadow copy and mark digits dirty;
+   display_flush() stores the dirty digits and nothing else, so a
+   clock that ticks once a second costs one or two MMIO writes per
+   tick instead of six. Digit 0 is the rightmost display.
+
+   Not reentrant: update the displays from one context only (main or
+   a single interrupt handler). */
+
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#define DISPLAY_DIGITS 6
+#define DISPLAY_BLANK  0xFF             /* Active low: all segments off. */
+
+/* Raw segment pattern for digit n. */
+void display_raw(int n, unsigned char segments);
+
+/* Decimal digit 0..9 at position n; anything else blanks it. */
+void display_digit(int n, int value);
+
+/* Two digits, 0..99, at positions 2*pair and 2*pair + 1. */
+void display_pair(int pair, unsigned value);
+
+/* hh:mm:ss in binary, hours on the left. */
+void display_clock(int hours, int minutes, int seconds);
+
+/* Six BCD (or hex) nibbles, lowest nibble rightmost. Takes mytime as is. */
+void display_bcd(unsigned bcd);
+
+/* Write the digits changed since the last flush. */
+void display_flush(void);
+
+#endif
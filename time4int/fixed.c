@@ -0,0 +1,269 @@
+/* fixed.c
+
+   Division runs on magnitudes. (n << shift) / d takes one hardware
+   divide for the integer part; the fraction takes one more when the
+   remainder can be shifted left without overflow (d < 2^(32-shift)),
+   and is otherwise developed a bit at a time. */
+
+#include "fixed.h"
+#include "fmt.h"
+
+static inline unsigned magnitude(int x)
+{
+  return x < 0 ? 0u - (unsigned) x : (unsigned) x;
+}
+
+/* The signed result of a magnitude: q may be up to 2^31 when negative. */
+static inline int saturate(unsigned q, int neg)
+{
+  if (neg)
+    return q >= 0x80000000u ? (int) 0x80000000u : -(int) q;
+  return q >= 0x80000000u ? 0x7FFFFFFF : (int) q;
+}
+
+static inline int saturate64(long long x)
+{
+  if (x > 0x7FFFFFFFll)
+    return 0x7FFFFFFF;
+  if (x < -0x80000000ll)
+    return (int) 0x80000000u;
+  return (int) x;
+}
+
+static int add_sat(int a, int b)
+{
+  int s = (int) ((unsigned) a + (unsigned) b);
+
+  if (((a ^ s) & (b ^ s)) < 0)
+    s = a < 0 ? (int) 0x80000000u : 0x7FFFFFFF;
+  return s;
+}
+
+static int sub_sat(int a, int b)
+{
+  int s = (int) ((unsigned) a - (unsigned) b);
+
+  if (((a ^ b) & (a ^ s)) < 0)
+    s = a < 0 ? (int) 0x80000000u : 0x7FFFFFFF;
+  return s;
+}
+
+/* round((n << shift) / d); 0xFFFFFFFF when it needs 32 bits or more. */
+static unsigned div_shift(unsigned n, unsigned d, int shift)
+{
+  unsigned q = n / d, r = n - q * d;
+  int i;
+
+  if (q >> (31 - shift))
+    return 0xFFFFFFFFu;
+  if ((d >> (32 - shift)) == 0) {
+    unsigned t = r << shift, f = t / d;
+    q = (q << shift) | f;
+    r = t - f * d;
+  } else {
+    for (i = 0; i < shift; i++) {
+      r <<= 1;
+      q <<= 1;
+      if (r >= d) {
+        r -= d;
+        q |= 1;
+      }
+    }
+  }
+  if (r >= d - r)
+    q++;
+  return q;
+}
+
+static int div_signed(int a, int b, int shift)
+{
+  int neg = (a ^ b) < 0;
+
+  if (b == 0)
+    return a == 0 ? 0 : saturate(0xFFFFFFFFu, a < 0);
+  return saturate(div_shift(magnitude(a), magnitude(b), shift), neg);
+}
+
+fix16_t fix16_add(fix16_t a, fix16_t b)
+{
+  return add_sat(a, b);
+}
+
+fix16_t fix16_sub(fix16_t a, fix16_t b)
+{
+  return sub_sat(a, b);
+}
+
+fix16_t fix16_mul(fix16_t a, fix16_t b)
+{
+  return saturate64(((long long) a * b + 0x8000) >> 16);
+}
+
+fix16_t fix16_div(fix16_t a, fix16_t b)
+{
+  return div_signed(a, b, 16);
+}
+
+fix16_t fix16_recip(fix16_t x)
+{
+  return div_signed(FIX16_ONE, x, 16);
+}
+
+fix16_t fix16_from_frac(int num, int den)
+{
+  return div_signed(num, den, 16);
+}
+
+/* Integer square root of x << 16, digit by digit in base 4. */
+fix16_t fix16_sqrt(fix16_t x)
+{
+  unsigned long long n, root = 0, bit = 1ull << 46;
+
+  if (x <= 0)
+    return 0;
+  n = (unsigned long long) x << 16;
+  while (bit > n)
+    bit >>= 2;
+  while (bit != 0) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  if (n > root)
+    root++;
+  return (fix16_t) root;
+}
+
+q31_t q31_add(q31_t a, q31_t b)
+{
+  return add_sat(a, b);
+}
+
+q31_t q31_sub(q31_t a, q31_t b)
+{
+  return sub_sat(a, b);
+}
+
+q31_t q31_mul(q31_t a, q31_t b)
+{
+  return saturate64(((long long) a * b + 0x40000000) >> 31);
+}
+
+q31_t q31_div(q31_t a, q31_t b)
+{
+  return div_signed(a, b, 31);
+}
+
+static const unsigned pow10[10] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/* ipart + frac / 2^32. */
+static int fmt_fixed(char *buf, int neg, unsigned ipart, unsigned frac,
+                     int decimals)
+{
+  unsigned scale, digits;
+  char *p = buf;
+  char tmp[12];
+  int n, i;
+
+  if (decimals < 0)
+    decimals = 0;
+  if (decimals > 9)
+    decimals = 9;
+  scale = pow10[decimals];
+  digits = ((unsigned long long) frac * scale + 0x80000000u) >> 32;
+  if (digits >= scale) {
+    ipart++;
+    digits -= scale;
+  }
+  if (neg && (ipart != 0 || digits != 0))
+    *p++ = '-';
+  p += fmt_udec(p, ipart);
+  if (decimals > 0) {
+    *p++ = '.';
+    n = fmt_udec(tmp, digits);
+    for (i = n; i < decimals; i++)
+      *p++ = '0';
+    for (i = 0; i < n; i++)
+      *p++ = tmp[i];
+  }
+  *p = '\0';
+  return p - buf;
+}
+
+int fix16_fmt(char *buf, fix16_t x, int decimals)
+{
+  unsigned m = magnitude(x);
+
+  return fmt_fixed(buf, x < 0, m >> 16, m << 16, decimals);
+}
+
+int q31_fmt(char *buf, q31_t x, int decimals)
+{
+  unsigned m = magnitude(x);
+
+  return fmt_fixed(buf, x < 0, m >> 31, m << 1, decimals);
+}
+
+#ifdef FIXED_BENCH
+#include "console.h"
+#include "dtekv-csr.h"
+
+#define BENCH_N 256                     /* Power of two. */
+
+static volatile fix16_t xa = 0x00031415, xb = 0x00012345, xr;
+static volatile float fa = 3.0799f, fb = 1.1377f, fr;
+static volatile int ir;
+
+static void report(const char *op, unsigned fixed, unsigned soft)
+{
+  char line[64];
+
+  console_write(line, fmt(line, "FIXED %s fix16=%u float=%u cycles/op\n",
+                          op, fixed, soft));
+}
+
+/* Both loops load volatile operands and store a volatile result, so
+   the per-op figures include the same loop overhead. */
+#define BENCH(op, fixed_stmt, float_stmt) do {                  \
+    unsigned c0, c1, c2;                                        \
+    c0 = (unsigned) read_mcycle();                              \
+    for (i = 0; i < BENCH_N; i++)                               \
+      fixed_stmt;                                               \
+    c1 = (unsigned) read_mcycle();                              \
+    for (i = 0; i < BENCH_N; i++)                               \
+      float_stmt;                                               \
+    c2 = (unsigned) read_mcycle();                              \
+    report(op, (c1 - c0) / BENCH_N, (c2 - c1) / BENCH_N);       \
+  } while (0)
+
+void fixed_bench(void)
+{
+  char line[48], num[20];
+  unsigned t0, t1;
+  int i;
+
+  BENCH("add", xr = fix16_add(xa, xb), fr = fa + fb);
+  BENCH("mul", xr = fix16_mul(xa, xb), fr = fa * fb);
+  BENCH("div", xr = fix16_div(xa, xb), fr = fa / fb);
+  BENCH("recip", xr = fix16_recip(xa), fr = 1.0f / fa);
+  BENCH("to_int", ir = fix16_to_int(xa), ir = (int) fa);
+  BENCH("from_int", xr = fix16_from_int(ir), fr = (float) ir);
+
+  /* softfloat.a has no square root to compare with. */
+  t0 = (unsigned) read_mcycle();
+  for (i = 0; i < BENCH_N; i++)
+    xr = fix16_sqrt(xa);
+  t1 = (unsigned) read_mcycle();
+  console_write(line, fmt(line, "FIXED sqrt fix16=%u cycles/op\n",
+                          (t1 - t0) / BENCH_N));
+  fix16_fmt(num, fix16_sqrt(fix16_from_int(2)), 5);
+  console_write(line, fmt(line, "FIXED sqrt(2)=%s\n", num));
+  console_flush();
+}
+#endif
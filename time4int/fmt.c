@@ -0,0 +1,122 @@
+/* fmt.c
+
+   Decimal conversion peels off two digits at a time: x / 100 is a
+   mulhu and a shift (0x51EB851F / 2^37 is exact for every 32-bit x),
+   and the two-digit remainder indexes a 200-byte table. Hex conversion
+   maps each nibble with a compare and a mask instead of a branch. */
+
+#include <stdarg.h>
+#include "fmt.h"
+
+static const char digit_pairs[200] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static inline unsigned div100(unsigned x)
+{
+  return (unsigned) (((unsigned long long) x * 0x51EB851Fu) >> 37);
+}
+
+int fmt_udec(char *buf, unsigned x)
+{
+  char tmp[10];
+  char *p = tmp + sizeof(tmp);
+  int len, i;
+
+  while (x >= 100) {
+    unsigned q = div100(x);
+    const char *pair = &digit_pairs[2 * (x - q * 100)];
+    *--p = pair[1];
+    *--p = pair[0];
+    x = q;
+  }
+  if (x >= 10) {
+    *--p = digit_pairs[2 * x + 1];
+    *--p = digit_pairs[2 * x];
+  } else {
+    *--p = '0' + x;
+  }
+
+  len = tmp + sizeof(tmp) - p;
+  for (i = 0; i < len; i++)
+    buf[i] = p[i];
+  buf[len] = '\0';
+  return len;
+}
+
+int fmt_dec(char *buf, int x)
+{
+  if (x < 0) {
+    buf[0] = '-';
+    return 1 + fmt_udec(buf + 1, 0u - (unsigned) x);
+  }
+  return fmt_udec(buf, x);
+}
+
+int fmt_hex32(char *buf, unsigned x)
+{
+  int i;
+
+  for (i = 7; i >= 0; i--) {
+    unsigned nib = x & 0xf;
+    /* 7 more for 10..15 so they land on 'A'..'F'. */
+    buf[i] = '0' + nib + (((unsigned) (nib < 10) - 1) & 7);
+    x >>= 4;
+  }
+  buf[8] = '\0';
+  return 8;
+}
+
+int fmt(char *buf, const char *f, ...)
+{
+  va_list ap;
+  char *out = buf;
+
+  va_start(ap, f);
+  while (*f != '\0') {
+    if (*f != '%') {
+      *out++ = *f++;
+      continue;
+    }
+    f++;
+    switch (*f) {
+    case 'u':
+      out += fmt_udec(out, va_arg(ap, unsigned));
+      break;
+    case 'd':
+      out += fmt_dec(out, va_arg(ap, int));
+      break;
+    case 'x':
+      out += fmt_hex32(out, va_arg(ap, unsigned));
+      break;
+    case 's': {
+      const char *s = va_arg(ap, const char *);
+      while (*s != '\0')
+        *out++ = *s++;
+      break;
+    }
+    case 'c':
+      *out++ = (char) va_arg(ap, int);
+      break;
+    case '%':
+      *out++ = '%';
+      break;
+    default:                    /* Unknown or truncated conversion. */
+      if (*f == '\0')
+        f--;
+      break;
+    }
+    f++;
+  }
+  va_end(ap);
+  *out = '\0';
+  return out - buf;
+}
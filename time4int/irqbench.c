@@ -0,0 +1,142 @@
+/* irqbench.c
+
+   The timer runs in continuous mode, so at a timeout the counter
+   reloads with the period and keeps counting down. The handler
+   latches the counter through the snapshot registers as its first
+   action; reload - snapshot is then the number of cycles between the
+   timeout and the handler running. Lost ticks are found by comparing
+   the handled count with the number of periods that fit between the
+   first and last sample. */
+
+#include "irqbench.h"
+#include "console.h"
+#include "dtekv-csr.h"
+#include "dtekv-hw.h"
+#include "fmt.h"
+#include "sieve.h"
+#include "trap.h"
+
+#define CLOCK_HZ      30000000u
+#define START_PERIOD  3000000u
+#define MIN_PERIOD    64u
+#define STEP_BUDGET   15000000u          /* Cycles per sweep step, ~0.5 s. */
+#define MIN_SAMPLES   16u
+#define MAX_SAMPLES   4096u
+
+#define HIST_SHIFT    2                   /* 4-cycle buckets */
+#define HIST_BUCKETS  256                 /* Last bucket catches the rest. */
+
+static unsigned short hist[HIST_BUCKETS];
+static volatile unsigned samples;
+static volatile unsigned target;
+static unsigned reload;                  /* Counter value at a timeout. */
+static unsigned lat_min, lat_max;
+static unsigned first_cycle, last_cycle;
+
+static void bench_timer_interrupt(unsigned cause)
+{
+  unsigned snap, lat, bucket;
+
+  snap = hw_timer_snapshot();
+  hw_timer_ack();
+
+  if (samples >= target)
+    return;
+  lat = reload - snap;
+  if (samples == 0)
+    first_cycle = (unsigned) read_mcycle() - lat;
+  last_cycle = (unsigned) read_mcycle() - lat;
+
+  bucket = lat >> HIST_SHIFT;
+  hist[bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1]++;
+  if (lat < lat_min)
+    lat_min = lat;
+  if (lat > lat_max)
+    lat_max = lat;
+  samples++;
+}
+
+/* Upper edge of the bucket holding the given rank (0-based). */
+static unsigned percentile(unsigned rank)
+{
+  unsigned i, seen = 0;
+
+  for (i = 0; i < HIST_BUCKETS - 1; i++) {
+    seen += hist[i];
+    if (seen > rank)
+      return ((i + 1) << HIST_SHIFT) - 1;
+  }
+  return lat_max;
+}
+
+/* One sweep step; returns the number of lost ticks. */
+static unsigned measure(unsigned p, int load)
+{
+  char line[128];
+  unsigned i, n, expected, lost;
+
+  for (i = 0; i < HIST_BUCKETS; i++)
+    hist[i] = 0;
+  n = STEP_BUDGET / p;
+  if (n < MIN_SAMPLES) n = MIN_SAMPLES;
+  if (n > MAX_SAMPLES) n = MAX_SAMPLES;
+  lat_min = ~0u;
+  lat_max = 0;
+  samples = 0;
+  target = n;
+  reload = p - 1;                         /* Counter runs p-1..0: p cycles. */
+
+  hw_timer_start(reload, TIMER_CONT | TIMER_ITO);
+  while (samples < target) {
+    if (load)
+      prime_iter_next();
+  }
+  hw_timer_stop();
+
+  /* Periods between first and last sample, rounded to nearest. */
+  expected = (last_cycle - first_cycle + p / 2) / p;
+  lost = expected > n - 1 ? expected - (n - 1) : 0;
+
+  console_write(line, fmt(line,
+      "IRQBENCH load=%s period=%u samples=%u lost=%u min=%u p50=%u p99=%u max=%u\n",
+      load ? "prime" : "idle", p, n, lost, lat_min,
+      percentile(n / 2), percentile(n - 1 - n / 100), lat_max));
+  console_flush();
+  return lost;
+}
+
+void irqbench_run(void)
+{
+  char line[80];
+  unsigned saved_mie, saved_mstatus;
+  int load;
+
+  __asm__ volatile ("csrr %0, mie" : "=r"(saved_mie));
+  __asm__ volatile ("csrrci %0, mstatus, 8" : "=r"(saved_mstatus));
+
+  irq_register(IRQ_TIMER, bench_timer_interrupt);
+  irq_enable(IRQ_TIMER);
+  prime_iter_init(1234567);
+  __asm__ volatile ("csrsi mstatus, 8");
+
+  for (load = 0; load < 2; load++) {
+    unsigned p, best = 0;
+
+    for (p = START_PERIOD; p >= MIN_PERIOD; p -= p / 4) {
+      if (measure(p, load) != 0)
+        break;
+      best = p;
+    }
+    console_write(line, fmt(line, "IRQBENCH_MAX load=%s period=%u hz=%u\n",
+                            load ? "prime" : "idle", best,
+                            best ? CLOCK_HZ / best : 0));
+  }
+
+  __asm__ volatile ("csrc mstatus, %0" :: "r"(8));
+  hw_timer_stop();
+  hw_timer_ack();
+  irq_register(IRQ_TIMER, 0);
+  __asm__ volatile ("csrw mie, %0" :: "r"(saved_mie));
+  __asm__ volatile ("csrs mstatus, %0" :: "r"(saved_mstatus & 8));
+  console_flush();
+}
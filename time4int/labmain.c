@@ -1,4 +1,18 @@
 #include <stdio.h>
+#include "sieve.h"
+#include "clock.h"
+#include "console.h"
+#include "delay.h"
+#include "display.h"
+#include "dtekv-hw.h"
+#include "fixed.h"
+#include "fmt.h"
+#include "meter.h"
+#include "prof.h"
+#include "stack.h"
+#include "startup.h"
+#include "tickless.h"
+#include "irqbench.h"
 
 /* main.c
 
@@ -14,6 +28,7 @@ extern void time2string(char*, int);
 extern void tick(int*);
 extern void delay(int);
 extern int nextprime(int);
+extern void bench_nextprime(void);
 
 int mytime = 0x5957;
 char textstring[] = "text, more text, and even more text!";
@@ -28,41 +43,68 @@ int minutes = 0;
 int seconds = 0;
 char textbuffer[30];  // Buffer for time2string
 
+// Profiler regions (build with CPPFLAGS=-DPROF_ENABLE)
+enum { PROF_IRQ, PROF_TICK, PROF_TIME2STRING, PROF_PRIME };
+
 // Helper function to read the Second Button (Bit 1)
 int get_btn(void) {
-    return *(volatile int*)0x040000d0 & 1;
+    return hw_buttons() & 1;
 }
 
 // Helper function to read Switches
 int get_sw(void) {
-    volatile int* sw_ptr = (volatile int*)0x04000010;
-    return *sw_ptr & 0x3FF;
+    return hw_switches();
 }
 
 void set_displays(int display_number, int value) {
-    static const int hex_codes[] = {
-        0xC0, 0xF9, 0xA4, 0xB0, 0x99,
-        0x92, 0x82, 0xF8, 0x80, 0x90};
-    volatile int* display_ptr = (volatile int*)(0x04000050 + (display_number * 0x10));
-    if (value >= 0 && value <= 9) {
-        *display_ptr = hex_codes[value];
-    } else {
-        *display_ptr = 0xFF;
+    display_digit(display_number, value);
+    display_flush();
+}
+
+// Once a second: apply a button/switch time set, advance and show the clock
+static void clock_second(void) {
+    // --- Button Logic ---
+    if (get_btn() != 0)
+        clock_set_from_switches(&hours, &minutes, &seconds, get_sw());
+
+    // --- 7-Segment Clock Logic ---
+    clock_add_seconds(&hours, &minutes, &seconds, 1);
+    meter_second();  // CPPFLAGS=-DPRIME_METER, see meter.h
+
+    // Update the display registers (only the digits that changed),
+    // unless the meter has them
+    if (!meter_show(get_sw())) {
+        display_clock(hours, minutes, seconds);
+        display_flush();
     }
 }
 
+#ifdef TICKLESS
+// One timer interrupt per second instead of ten (see tickless.c).
+// mytime keeps the rate of the periodic build: ten ticks per second,
+// applied together
+static void tickless_second(void) {
+    int i;
+
+    PROF_BEGIN(PROF_IRQ);
+    clock_second();
+
+    PROF_BEGIN(PROF_TICK);
+    for (i = 0; i < 10; i++)
+        tick(&mytime);
+    PROF_END(PROF_TICK);
+    PROF_END(PROF_IRQ);
+}
+#endif
+
 // INTERRUPT HANDLER
 void handle_interrupt(unsigned int cause) {
-    volatile int* timer_status = (volatile int*)(0x04000020);
-    int current_btn;
-    int sw_val;
-    int selector;
-    int value;
+    PROF_BEGIN(PROF_IRQ);
 
     // Check if the interrupt was caused by the Timer (Bit 0 of Status is 1)
-    if ((*timer_status & 1) == 1) {
+    if (hw_timer_timeout()) {
         // Acknowledge the interrupt by clearing the status register
-        *timer_status = 0;
+        hw_timer_ack();
 
         // Increment the global counter
         timeoutcount++;
@@ -70,75 +112,68 @@ void handle_interrupt(unsigned int cause) {
         // Only update displays and time once every 10 timeouts (1 Second)
         if (timeoutcount >= 10) {
             timeoutcount = 0;
-
-            // --- Button Logic ---
-            current_btn = get_btn();
-            if (current_btn != 0) {
-                sw_val = get_sw();
-                selector = (sw_val >> 8) & 0x03;
-                value = sw_val & 0x3F;
-
-                if (selector == 1) {  // Set Seconds
-                    seconds = (value < 60) ? value : 59;
-                } else if (selector == 2) {  // Set Minutes
-                    minutes = (value < 60) ? value : 59;
-                } else if (selector == 3) {  // Set Hours
-                    hours = (value < 24) ? value : 23;
-                }
-            }
-
-            // --- 7-Segment Clock Logic ---
-            seconds++;
-            if (seconds >= 60) {
-                seconds = 0;
-                minutes++;
-                if (minutes >= 60) {
-                    minutes = 0;
-                    hours++;
-                    if (hours >= 24) {
-                        hours = 0;
-                    }
-                }
-            }
-
-            // Update the display registers
-            set_displays(0, seconds % 10);
-            set_displays(1, seconds / 10);
-            set_displays(2, minutes % 10);
-            set_displays(3, minutes / 10);
-            set_displays(4, hours % 10);
-            set_displays(5, hours / 10);
+            clock_second();
         }
     }
 
+    PROF_BEGIN(PROF_TICK);
     tick(&mytime);
+    PROF_END(PROF_TICK);
+
+    PROF_END(PROF_IRQ);
 }
 
 /* Initialize Interrupts and Timer */
 void labinit(void) {
-    volatile int* timer_periodl = (volatile int*)(0x04000020 + 0x8);
-    volatile int* timer_periodh = (volatile int*)(0x04000020 + 0xC);
-    volatile int* timer_control = (volatile int*)(0x04000020 + 0x4);
-    volatile int* timer_status = (volatile int*)(0x04000020);
-
-    // 1. Setup Timer Hardware (3,000,000 cycles = 100ms)
-    *timer_periodl = 0xC6C0;
-    *timer_periodh = 0x002D;
-
-    // Start Timer + Continuous + Interrupt Enable (ITO)
-    *timer_control = 0x7;
-
-    // Clear pending status
-    *timer_status = 0;
+#ifdef TICKLESS
+    // Build with CPPFLAGS=-DTICKLESS: timer armed for each deadline
+    tickless_start(tickless_second);
+#else
+    // 1. Setup Timer Hardware (3,000,000 cycles = 100ms), cleared
+    // status, then Start + Continuous + Interrupt Enable (ITO)
+    hw_timer_start(3000000, TIMER_CONT | TIMER_ITO);
+#endif
+    startup_clock_started();
 }
 
 int main() {
+#ifdef DELAY_BENCH
+    delay_init();  // 10 ms calibration, before anything starts the timer
+    delay_selftest();
+#endif
+#ifdef PRIME_BENCH
+    bench_nextprime();
+#endif
+#ifdef IRQ_BENCH
+    irqbench_run();
+#endif
+#ifdef FIXED_BENCH
+    fixed_bench();
+#endif
+    PROF_NAME(PROF_IRQ, "irq");
+    PROF_NAME(PROF_TICK, "tick");
+    PROF_NAME(PROF_PRIME, "prime");
     labinit();
+#ifdef BOOT_BANNER
+    startup_banner();
+#endif
+    prime_iter_init(prime);
 
     while (1) {
-        print("Prime: ");
-        prime = nextprime(prime);
-        print_dec(prime);
-        print("\n");
+        char line[24];
+        PROF_BEGIN(PROF_PRIME);
+        prime = prime_iter_next();
+        PROF_END(PROF_PRIME);
+        meter_prime(prime);
+        console_write(line, fmt(line, "Prime: %u\n", prime));
+        meter_poll();
+#ifdef PROF_ENABLE
+        if ((prime & 0xfff) == 1)  // now and then
+            prof_dump();
+#endif
+#ifdef STACK_PAINT
+        if ((prime & 0xfff) == 1)  // now and then
+            stack_report();
+#endif
     }
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+/* stack.c */
+
+#include "stack.h"
+#include "console.h"
+#include "fmt.h"
+
+extern char _stack_begin[], _stack_end[];
+
+unsigned stack_unused(const void *lo, const void *hi)
+{
+  const unsigned *p = lo;
+
+  while (p < (const unsigned *) hi && *p == STACK_PAINT_WORD)
+    p++;
+  return (const char *) p - (const char *) lo;
+}
+
+unsigned stack_high_water(void)
+{
+#ifdef STACK_PAINT
+  return (_stack_end - _stack_begin) - stack_unused(_stack_begin, _stack_end);
+#else
+  return 0;
+#endif
+}
+
+void stack_report(void)
+{
+  char line[48];
+
+  console_write(line, fmt(line, "STACK high=%u size=%u\n", stack_high_water(),
+                          (unsigned) (_stack_end - _stack_begin)));
+}
@@ -0,0 +1,44 @@
+/* syscall.h
+
+   System calls, dispatched by number through syscall_table.
+
+   ecall takes the number in a7 and arguments in a0-a2, and returns in
+   a0 (and a1 for 64-bit results). The trap entry treats it as an
+   ordinary function call: it keeps only ra and reloads nothing else
+   on the way out, so an ecall clobbers every register a call may
+   clobber (t0-t6, a0-a7), keeps the callee-saved ones, and costs a
+   few instructions plus the handler itself.
+
+   Everything on this board runs in M-mode, so code that is not tied
+   to the trap can skip it: sys_call() calls the same handler
+   directly, and the C functions behind the handlers (print, printc,
+   console_write, read_mcycle) can be called as they are. */
+
+#ifndef SYSCALL_H
+#define SYSCALL_H
+
+#define SYS_MAX     32
+
+#define SYS_PRINT   4                   /* a0 = '\0'-terminated string */
+#define SYS_PUTC    11                  /* a0 = character */
+#define SYS_WRITE   16                  /* a0 = buffer, a1 = length; returns bytes queued */
+#define SYS_CYCLES  30                  /* Returns mcycle in a0 (low), a1 (high). */
+
+#ifndef __ASSEMBLER__
+
+typedef unsigned long long (*syscall_fn)(unsigned a0, unsigned a1, unsigned a2);
+
+extern syscall_fn syscall_table[SYS_MAX];
+
+/* Install fn for num; a null fn restores the default, which returns -1. */
+void syscall_register(unsigned num, syscall_fn fn);
+
+static inline unsigned long long sys_call(unsigned num, unsigned a0,
+                                          unsigned a1, unsigned a2)
+{
+  return syscall_table[num < SYS_MAX ? num : 0](a0, a1, a2);
+}
+
+#endif
+
+#endif
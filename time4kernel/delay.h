@@ -0,0 +1,32 @@
+/* delay.h
+
+   Busy-wait and sleeping delays measured on mcycle.
+
+   The delays count the nominal 30 MHz unless delay_init() has
+   measured mcycle against the interval timer. Calibration busy-waits
+   10 ms, needs the timer to itself and leaves it stopped, so the labs
+   only run it in DELAY_BENCH builds, before the timer is set up. If
+   the timer is already running it keeps the nominal clock.
+
+   Delays longer than DELAY_WFI_MS sleep in wfi between checks when a
+   timer interrupt is armed to wake the core, and spin otherwise. */
+
+#ifndef DELAY_H
+#define DELAY_H
+
+#define DELAY_NOMINAL_HZ 30000000u
+#define DELAY_WFI_MS     1
+
+void delay_init(void);
+void delay_us(unsigned us);
+void delay_ms(unsigned ms);
+
+/* Calibrated CPU clock in cycles per millisecond. */
+unsigned delay_cycles_per_ms(void);
+
+#ifdef DELAY_BENCH
+/* Print how far each delay length lands from its target. */
+void delay_selftest(void);
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+/* fixed.h
+
+   Fixed-point arithmetic, so fractional values stay out of
+   softfloat.a: the core has no F extension and every float operation
+   is a library call of a hundred cycles or more.
+
+   fix16_t is Q16.16: range [-32768, 32768), step 1/65536.
+   q31_t is Q1.31: range [-1, 1), step 2^-31; for ratios and gains.
+
+   All operations saturate instead of wrapping and round to nearest.
+   Multiplication is a mul/mulh pair; division and square root use
+   the 32-bit divider and shifts only, since libgcc (and with it any
+   64-bit division) is not linked.
+
+   Build with CPPFLAGS=-DFIXED_BENCH for fixed_bench(), which prints
+   cycles per operation next to the softfloat.a equivalent. */
+
+#ifndef FIXED_H
+#define FIXED_H
+
+typedef int fix16_t;
+typedef int q31_t;
+
+#define FIX16_ONE 0x00010000
+#define FIX16_MAX 0x7FFFFFFF
+#define FIX16_MIN (-0x7FFFFFFF - 1)
+#define Q31_MAX   0x7FFFFFFF
+#define Q31_MIN   (-0x7FFFFFFF - 1)
+
+static inline fix16_t fix16_from_int(int x)
+{
+  if (x > 0x7FFF)
+    return FIX16_MAX;
+  if (x < -0x8000)
+    return FIX16_MIN;
+  return x * FIX16_ONE;
+}
+
+/* Rounded to nearest, halves up. */
+static inline int fix16_to_int(fix16_t x)
+{
+  return (x >> 16) + ((x >> 15) & 1);
+}
+
+static inline q31_t q31_from_fix16(fix16_t x)
+{
+  if (x >= FIX16_ONE)
+    return Q31_MAX;
+  if (x < -FIX16_ONE)
+    return Q31_MIN;
+  return x * 0x8000;
+}
+
+static inline fix16_t fix16_from_q31(q31_t x)
+{
+  return (x >> 15) + ((x >> 14) & 1);
+}
+
+fix16_t fix16_add(fix16_t a, fix16_t b);
+fix16_t fix16_sub(fix16_t a, fix16_t b);
+fix16_t fix16_mul(fix16_t a, fix16_t b);
+fix16_t fix16_div(fix16_t a, fix16_t b);        /* x / 0 saturates. */
+fix16_t fix16_recip(fix16_t x);
+fix16_t fix16_sqrt(fix16_t x);                  /* 0 for x <= 0 */
+fix16_t fix16_from_frac(int num, int den);      /* num / den */
+
+q31_t q31_add(q31_t a, q31_t b);
+q31_t q31_sub(q31_t a, q31_t b);
+q31_t q31_mul(q31_t a, q31_t b);
+q31_t q31_div(q31_t a, q31_t b);                /* Saturates unless |a| < |b|. */
+
+/* Decimal with 0..9 digits after the point, rounded; returns the
+   length. At most 17 characters plus the '\0'. */
+int fix16_fmt(char *buf, fix16_t x, int decimals);
+int q31_fmt(char *buf, q31_t x, int decimals);
+
+void fixed_bench(void);
+
+#endif
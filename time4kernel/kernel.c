@@ -0,0 +1,224 @@
+/* kernel.c
+
+   Scheduler, semaphores and the hooks called from boot.S.
+
+   A task that is not running keeps its whole context on its own
+   stack, as two 64-byte frames: the trap frame written by the trap
+   entry (ra, t0-t6, a0-a7) and above it, at a lower address, the
+   switch frame written by _kernel_switch (s0-s11, mepc, mstatus).
+   task->sp points at the switch frame. */
+
+#include "kernel.h"
+#include "dtekv-hw.h"
+#include "dtekv-lib.h"
+#include "startup.h"
+#include "syscall.h"
+#include "sync.h"
+#include "trap.h"
+
+#define TRAP_WORDS   16                 /* Same layout as FRAME in boot.S. */
+#define SWITCH_WORDS 16
+#define TRAP_RA      0
+#define TRAP_A0      4
+#define SWITCH_MEPC  12
+#define SWITCH_MSTATUS 13
+
+#define MSTATUS_MPIE 0x80
+#define MSTATUS_MPP  0x1800             /* Return to machine mode. */
+
+enum { TASK_FREE, TASK_READY, TASK_SLEEPING, TASK_BLOCKED };
+
+struct task {
+  unsigned *sp;                         /* Saved switch frame. */
+  unsigned char prio;
+  unsigned char state;
+  unsigned wake;                        /* kernel_ticks to wake at. */
+  struct sem *wait;                     /* Semaphore blocked on. */
+};
+
+extern char _stack_begin[], _stack_end[];
+extern void _kernel_launch(unsigned *sp);
+
+volatile unsigned kernel_ticks;
+volatile int kernel_switch;             /* Read by the trap exit. */
+
+static struct task tasks[KERNEL_MAX_TASKS];
+static int ntasks;
+static struct task *current;
+static char *stack_next = _stack_begin;
+
+/* Where a task function returns to. */
+static void task_exit(void)
+{
+  irq_save();
+  current->state = TASK_FREE;
+  yield();
+  while (1);
+}
+
+int task_create(task_fn fn, void *arg, int prio, unsigned stack_size)
+{
+  struct task *t;
+  unsigned *sp;
+  int i;
+
+  if (stack_size == 0)
+    stack_size = KERNEL_STACK_SIZE;
+  stack_size = (stack_size + 15) & ~15u;
+  stack_next = (char*) (((unsigned) stack_next + 15) & ~15u);
+  if (ntasks == KERNEL_MAX_TASKS || (unsigned) prio >= KERNEL_PRIOS ||
+      stack_size > (unsigned) (_stack_end - KERNEL_BOOT_STACK - stack_next))
+    return -1;
+
+  /* Build the frames a trap would have left if fn had been
+     interrupted at its first instruction. */
+  sp = (unsigned*) (stack_next + stack_size) - TRAP_WORDS - SWITCH_WORDS;
+  stack_next += stack_size;
+  for (i = 0; i < TRAP_WORDS + SWITCH_WORDS; i++)
+    sp[i] = 0;
+  sp[SWITCH_MEPC] = (unsigned) fn;
+  sp[SWITCH_MSTATUS] = MSTATUS_MPP | MSTATUS_MPIE;
+  sp[SWITCH_WORDS + TRAP_RA] = (unsigned) task_exit;
+  sp[SWITCH_WORDS + TRAP_A0] = (unsigned) arg;
+
+  t = &tasks[ntasks];
+  t->sp = sp;
+  t->prio = prio;
+  t->state = TASK_READY;
+  return ntasks++;
+}
+
+/* Highest priority ready task, taking turns after current. */
+static struct task *pick(void)
+{
+  struct task *t = current;
+  unsigned prio = KERNEL_PRIOS;
+  int i;
+
+  for (i = 0; i < ntasks; i++)
+    if (tasks[i].state == TASK_READY && tasks[i].prio < prio)
+      prio = tasks[i].prio;
+
+  for (i = 0; i < ntasks; i++) {
+    if (++t == &tasks[ntasks])
+      t = tasks;
+    if (t->state == TASK_READY && t->prio == prio)
+      return t;
+  }
+  return current;
+}
+
+/* Called by _kernel_switch with the outgoing task's switch frame. */
+unsigned *kernel_schedule(unsigned *sp)
+{
+  kernel_switch = 0;
+  current->sp = sp;
+  current = pick();
+  return current->sp;
+}
+
+static void kernel_timer_interrupt(unsigned cause)
+{
+  unsigned now;
+  int i;
+
+  hw_timer_ack();
+  now = ++kernel_ticks;
+  for (i = 0; i < ntasks; i++)
+    if (tasks[i].state == TASK_SLEEPING && (int) (now - tasks[i].wake) >= 0)
+      tasks[i].state = TASK_READY;
+  kernel_switch = 1;                    /* End of the time slice. */
+}
+
+static unsigned long long sys_yield(unsigned a0, unsigned a1, unsigned a2)
+{
+  kernel_switch = 1;
+  return 0;
+}
+
+static void idle_task(void *arg)
+{
+  while (1)
+    __asm__ volatile ("wfi");
+}
+
+void kernel_start(unsigned tick_cycles)
+{
+  irq_save();
+  task_create(idle_task, 0, KERNEL_PRIOS - 1, 256);
+  syscall_register(SYS_YIELD, sys_yield);
+  irq_register(IRQ_TIMER, kernel_timer_interrupt);
+  hw_timer_start(tick_cycles - 1, TIMER_CONT | TIMER_ITO);
+  irq_enable(IRQ_TIMER);
+  startup_clock_started();
+
+  current = &tasks[ntasks - 1];
+  current = pick();
+  _kernel_launch(current->sp);
+}
+
+void task_sleep_until(unsigned tick)
+{
+  unsigned flags = irq_save();
+
+  if ((int) (tick - kernel_ticks) > 0) {
+    current->wake = tick;
+    current->state = TASK_SLEEPING;
+    yield();
+  }
+  irq_restore(flags);
+}
+
+void task_sleep(unsigned ticks)
+{
+  task_sleep_until(kernel_ticks + ticks);
+}
+
+void sem_wait(struct sem *s)
+{
+  unsigned flags = irq_save();
+
+  if (s->count > 0) {
+    s->count--;
+  } else {
+    current->wait = s;
+    current->state = TASK_BLOCKED;
+    yield();                            /* sem_post hands us the unit. */
+  }
+  irq_restore(flags);
+}
+
+/* Wake the best waiter, or bank the unit. Returns 1 if the woken task
+   should preempt the current one. Interrupts off. */
+static int post(struct sem *s)
+{
+  struct task *best = 0;
+  int i;
+
+  for (i = 0; i < ntasks; i++)
+    if (tasks[i].state == TASK_BLOCKED && tasks[i].wait == s &&
+        (!best || tasks[i].prio < best->prio))
+      best = &tasks[i];
+  if (!best) {
+    s->count++;
+    return 0;
+  }
+  best->wait = 0;
+  best->state = TASK_READY;
+  return best->prio < current->prio;
+}
+
+void sem_post_isr(struct sem *s)
+{
+  if (post(s))
+    kernel_switch = 1;
+}
+
+void sem_post(struct sem *s)
+{
+  unsigned flags = irq_save();
+
+  if (post(s))
+    yield();
+  irq_restore(flags);
+}
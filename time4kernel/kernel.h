@@ -0,0 +1,66 @@
+/* kernel.h
+
+   A small preemptive kernel on top of the trap entry in boot.S.
+
+   Tasks have a fixed priority, 0 being the highest, and the highest
+   priority ready task always runs. Tasks of equal priority share the
+   CPU round-robin, one timer tick at a time. Stacks are carved from
+   the .stack region of dtekv-script.lds, below the boot stack.
+
+   Interrupt handlers wake tasks through sem_post_isr(); a task that
+   makes a higher priority task ready with sem_post() gives up the CPU
+   on the spot. Every switch happens on the way out of a trap: the
+   trap entry already saved the caller-saved registers, and the rest
+   (s0-s11, mepc, mstatus) are only saved when the task really is
+   switched out. */
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#define KERNEL_MAX_TASKS   8
+#define KERNEL_PRIOS       4            /* KERNEL_PRIOS - 1 is the idle task. */
+#define KERNEL_STACK_SIZE  4096         /* Default task stack. */
+#define KERNEL_BOOT_STACK  0x10000      /* Left at the top for main. */
+
+#define SYS_YIELD          20           /* syscall_table slot of yield. */
+
+typedef void (*task_fn)(void *arg);
+
+struct sem {
+  volatile int count;
+};
+
+#define SEM_INIT(n) { (n) }
+
+/* Ticks since kernel_start(). */
+extern volatile unsigned kernel_ticks;
+
+/* Create a task; stack_size 0 picks KERNEL_STACK_SIZE. Returns the
+   task id, or -1 if out of task slots or stack space. Call before
+   kernel_start(). */
+int task_create(task_fn fn, void *arg, int prio, unsigned stack_size);
+
+/* Start the tick timer and run the tasks. Never returns. */
+void kernel_start(unsigned tick_cycles);
+
+/* Let the next ready task of the same or higher priority run. */
+static inline void yield(void)
+{
+  register unsigned a7 __asm__("a7") = SYS_YIELD;
+  /* An ecall clobbers what a call does (syscall.h). */
+  __asm__ volatile ("ecall" : "+r"(a7) ::
+                    "a0", "a1", "a2", "a3", "a4", "a5", "a6",
+                    "t0", "t1", "t2", "t3", "t4", "t5", "t6", "memory");
+}
+
+/* Block for a number of ticks, or until kernel_ticks reaches tick. */
+void task_sleep(unsigned ticks);
+void task_sleep_until(unsigned tick);
+
+/* Counting semaphores. sem_wait() blocks the calling task; a post
+   hands the unit straight to the highest priority waiter. */
+void sem_wait(struct sem *s);
+void sem_post(struct sem *s);          /* From a task. */
+void sem_post_isr(struct sem *s);      /* From an interrupt handler. */
+
+#endif
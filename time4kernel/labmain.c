@@ -0,0 +1,138 @@
+#include "sieve.h"
+#include "clock.h"
+#include "console.h"
+#include "delay.h"
+#include "display.h"
+#include "dtekv-hw.h"
+#include "kernel.h"
+#include "startup.h"
+#include "trap.h"
+
+/* main.c
+
+   This file written 2024 by Artur Podobas and Pedro Antunes
+
+   For copyright and licensing, see file COPYING */
+
+
+/* Below functions are external and found in other files. */
+extern void print(const char*);
+extern void print_dec(unsigned int);
+extern void display_string(char*);
+extern void time2string(char*,int);
+extern void tick(int*);
+
+/* The clock from suprise, split into tasks: the clock task advances
+   the time once a second, the input task handles button presses and
+   the prime task soaks up whatever CPU is left. */
+
+#define TICK_CYCLES      300000         /* 10 ms at 30 MHz */
+#define TICKS_PER_SECOND 100
+
+enum { PRIO_INPUT, PRIO_CLOCK, PRIO_PRIME };
+
+int mytime = 0x5957;
+
+int prime = 1234567;
+
+// Global Time Variables
+int hours = 0;
+int minutes = 0;
+int seconds = 0;
+char textbuffer[30];   // Buffer for time2string
+
+static struct sem clock_lock = SEM_INIT(1);   // Guards the time variables
+static struct sem button_sem = SEM_INIT(0);   // Posted by the button ISR
+
+/* Refresh the text clock and the 7-segment displays after a change. */
+static void update_outputs(void) {
+    tick(&mytime);
+    time2string(textbuffer, mytime);
+    display_string(textbuffer);
+
+    display_clock(hours, minutes, seconds);
+    display_flush();
+}
+
+static void add_seconds(int n) {
+    clock_add_seconds(&hours, &minutes, &seconds, n);
+}
+
+/* * CLOCK TASK
+ * Sleeps to absolute tick deadlines, so the second never drifts.
+ */
+static void clock_task(void *arg) {
+    unsigned next = kernel_ticks;
+
+    while (1) {
+        next += TICKS_PER_SECOND;
+        task_sleep_until(next);
+
+        sem_wait(&clock_lock);
+        add_seconds(1);
+        update_outputs();
+        sem_post(&clock_lock);
+    }
+}
+
+/* * INPUT TASK
+ * Woken by the button interrupt; a press adds two seconds.
+ */
+static void input_task(void *arg) {
+    while (1) {
+        sem_wait(&button_sem);
+
+        if (hw_buttons() & 1) {
+            sem_wait(&clock_lock);
+            add_seconds(2);
+            update_outputs();
+            sem_post(&clock_lock);
+        }
+    }
+}
+
+/* * PRIME TASK
+ * Lowest priority; preempted by the others and by every tick.
+ */
+static void prime_task(void *arg) {
+#ifdef BOOT_BANNER
+    startup_banner();  // the lowest priority runs once the clock does
+#endif
+    prime_iter_init(prime);
+    while (1) {
+        prime = prime_iter_next();
+        console_poll();
+    }
+}
+
+/* * BUTTON INTERRUPT (cause 18)
+ */
+void button_interrupt(unsigned cause) {
+    HW_WRITE(HW_BUTTONS->edge_capture, 0);
+    sem_post_isr(&button_sem);
+}
+
+/* * INTERRUPT HANDLER
+ * Fallback for every cause without its own handler (see trap.c).
+ */
+void handle_interrupt(unsigned cause) {
+    print("Cause: "); print_dec(cause); print("\n");
+}
+
+/* Initialize the button interrupt; the kernel owns the timer. */
+void labinit(void) {
+    HW_WRITE(HW_BUTTONS->irq_mask, 1);
+    HW_WRITE(HW_BUTTONS->edge_capture, 0);
+    irq_register(IRQ_BUTTON, button_interrupt);
+    irq_enable(IRQ_BUTTON);
+}
+
+int main() {
+    labinit();
+
+    task_create(input_task, 0, PRIO_INPUT, 0);
+    task_create(clock_task, 0, PRIO_CLOCK, 0);
+    task_create(prime_task, 0, PRIO_PRIME, 0);
+
+    kernel_start(TICK_CYCLES);
+}
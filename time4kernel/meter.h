@@ -0,0 +1,59 @@
+/* meter.h
+
+   Prime throughput meter.
+
+     meter_prime(prime);                 main loop, per prime found
+     meter_second();                     timer context, once a second
+     if (!meter_show(switches))          same context, after it
+       display_clock(...);
+     meter_poll();                       main loop, prints new samples
+
+   meter_prime() is two stores. Once a second meter_second() turns the
+   counts into a sample: primes found and odd candidates passed over
+   (half the distance the primes advanced) in that second, and mcycle
+   per prime, which includes every cycle the interrupts took away from
+   the search. A change to an ISR or to the prime engine shows up in
+   the next sample.
+
+   With switch METER_SW_HEX up the 7-segment displays show primes per
+   second instead of the clock; with METER_SW_LEDS up the LED bar shows
+   it as tenths of the best second so far. meter_poll() prints each
+   sample once:
+
+     METER primes/s=41231 cand/s=472918 cycles/prime=727 peak=41502
+
+   Build with -DPRIME_METER (make CPPFLAGS=-DPRIME_METER) to turn it
+   on. Without it every function is an empty inline and meter_show()
+   returns 0, so the calls can stay in the labs. */
+
+#ifndef METER_H
+#define METER_H
+
+#define METER_SW_HEX   (1u << 7)
+#define METER_SW_LEDS  (1u << 6)
+
+#ifdef PRIME_METER
+
+extern volatile unsigned meter_primes;
+extern volatile unsigned meter_last;
+
+static inline void meter_prime(unsigned prime)
+{
+  meter_primes++;
+  meter_last = prime;
+}
+
+void meter_second(void);
+int meter_show(unsigned switches);
+void meter_poll(void);
+
+#else
+
+static inline void meter_prime(unsigned prime) {}
+static inline void meter_second(void) {}
+static inline int meter_show(unsigned switches) { return 0; }
+static inline void meter_poll(void) {}
+
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+/* prof.c
+
+   Storage and report for the region profiler, see prof.h. */
+
+#include "prof.h"
+
+#ifdef PROF_ENABLE
+
+#include "dtekv-lib.h"
+#include "fmt.h"
+
+struct prof_region prof_regions[PROF_MAX_REGIONS];
+
+/* sum / count without a 64-bit divide: scale both down until the
+   numerator fits in 32 bits. Good to 32 significant bits. */
+static unsigned mean(unsigned long long sum, unsigned count)
+{
+  while ((sum >> 32) != 0) {
+    sum >>= 1;
+    count >>= 1;
+  }
+  return count ? (unsigned) sum / count : 0;
+}
+
+static void column(unsigned long long v, int width)
+{
+  char buf[12];
+  int n;
+
+  if ((v >> 32) != 0) {
+    printc(' ');
+    print_dec64(v);
+    return;
+  }
+  n = fmt_udec(buf, (unsigned) v);
+  while (width-- > n)
+    printc(' ');
+  print(buf);
+}
+
+void prof_dump(void)
+{
+  int i;
+
+  print("region          count        min        max       mean   insn/call\n");
+  for (i = 0; i < PROF_MAX_REGIONS; i++) {
+    struct prof_region *r = &prof_regions[i];
+    int n = 0;
+
+    if (r->count == 0)
+      continue;
+    if (r->name != 0) {
+      print((char *) r->name);
+      while (r->name[n] != '\0')
+        n++;
+    } else {
+      print("#");
+      print_dec(i);
+      n = (i < 10) ? 2 : 3;
+    }
+    while (n++ < 12)
+      printc(' ');
+    column(r->count, 9);
+    column(r->min, 11);
+    column(r->max, 11);
+    column(mean(r->sum, r->count), 11);
+    column(mean(r->insns, r->count), 12);
+    printc('\n');
+  }
+}
+
+void prof_reset(void)
+{
+  int i;
+
+  for (i = 0; i < PROF_MAX_REGIONS; i++) {
+    prof_regions[i].count = 0;
+    prof_regions[i].sum = 0;
+    prof_regions[i].insns = 0;
+    prof_regions[i].max = 0;
+  }
+}
+
+#endif
@@ -0,0 +1,179 @@
+/* sieve.c
+
+   Segmented sieve of Eratosthenes over odd numbers only.
+
+   A window of SIEVE_WORDS 32-bit words covers SIEVE_BITS consecutive
+   odd numbers starting at window_lo; bit i stands for window_lo + 2*i
+   and is set once that number is known to be composite. When the
+   iterator runs off the end of a window the next one is sieved with
+   the table of base primes, which holds every odd prime up to
+   sqrt(2^31) and is built once on first use. Each window costs one
+   divide per base prime instead of one divide per trial factor.
+
+   Both tables, about 10 KB, come from the sieve arena on the heap
+   when the table is built. The heap is NOLOAD, so unlike .bss the
+   boot code does not spend cycles clearing them, and a lab that
+   never asks for a prime never touches them. */
+
+#include "sieve.h"
+#include "heap.h"
+#include "console.h"
+#include "dtekv-lib.h"
+
+#define SIEVE_WORDS   256
+#define SIEVE_BITS    (SIEVE_WORDS * 32)
+#define BASE_LIMIT    46341          /* > sqrt(2^31 - 1) */
+#define BASE_MAX      4800           /* Odd primes below BASE_LIMIT: 4791 */
+
+static struct arena sieve_arena;
+static unsigned *sieve_bits;                  /* SIEVE_WORDS words. */
+static unsigned short *base_primes;           /* BASE_MAX entries. */
+static int base_count = 0;
+
+static unsigned window_lo;      /* Odd number held in bit 0. */
+static unsigned next_bit;       /* First bit not yet handed out. */
+static int pending_two;         /* 2 is the only even prime, served apart. */
+
+/* Index of the lowest set bit of a non-zero word, without a ctz
+   instruction (rv32im has none) or a libgcc call. */
+static int lowest_bit(unsigned x)
+{
+  static const unsigned char debruijn[32] = {
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+  };
+  return debruijn[((x & (0 - x)) * 0x077CB531u) >> 27];
+}
+
+/* Mark the odd multiples of p, starting at odd multiple m, in the window. */
+static void cross_off(unsigned p, unsigned m)
+{
+  unsigned i = (m - window_lo) >> 1;
+  while (i < SIEVE_BITS) {
+    sieve_bits[i >> 5] |= 1u << (i & 31);
+    i += p;
+  }
+}
+
+/* Sieve the window that starts at the odd number lo. */
+static void sieve_window(unsigned lo)
+{
+  unsigned hi = lo + 2 * (SIEVE_BITS - 1);   /* Last number in the window. */
+  int i;
+
+  window_lo = lo;
+  next_bit = 0;
+  for (i = 0; i < SIEVE_WORDS; i++)
+    sieve_bits[i] = 0;
+  if (lo == 1)
+    sieve_bits[0] = 1;                        /* 1 is not prime. */
+
+  for (i = 0; i < base_count; i++) {
+    unsigned p = base_primes[i];
+    unsigned m;
+
+    if (p * p > hi)
+      break;
+    m = p * p;
+    if (m < lo) {
+      m = lo + p - 1;
+      m -= m % p;                             /* First multiple >= lo. */
+      if ((m & 1) == 0)
+        m += p;
+    }
+    cross_off(p, m);
+  }
+}
+
+/* Sieve the first window in place, finding its own base primes. */
+static void sieve_first_window(void)
+{
+  unsigned hi = 1 + 2 * (SIEVE_BITS - 1);
+  unsigned i, p;
+
+  sieve_window(1);
+  for (i = 1, p = 3; p * p <= hi; i++, p += 2)
+    if ((sieve_bits[i >> 5] & (1u << (i & 31))) == 0)
+      cross_off(p, p * p);
+}
+
+/* Take both tables from the heap. There is nothing sensible to
+   return to the labs without them, so a heap too small stops here. */
+static void alloc_tables(void)
+{
+  if (arena_init(&sieve_arena, "sieve", SIEVE_WORDS * sizeof(unsigned)
+                 + BASE_MAX * sizeof(unsigned short)) != 0) {
+    print("SIEVE heap too small\n");
+    console_flush();
+    while (1);
+  }
+  sieve_bits = arena_alloc(&sieve_arena, SIEVE_WORDS * sizeof(unsigned));
+  base_primes = arena_alloc(&sieve_arena, BASE_MAX * sizeof(unsigned short));
+}
+
+/* Collect every odd prime below BASE_LIMIT into base_primes. */
+static void build_base_primes(void)
+{
+  unsigned lo;
+  int n = 0;
+
+  alloc_tables();
+  sieve_first_window();
+  for (lo = 1; lo < BASE_LIMIT; lo += 2 * SIEVE_BITS) {
+    unsigned i;
+
+    if (lo != 1)
+      sieve_window(lo);
+    for (i = 0; i < SIEVE_BITS; i++) {
+      unsigned v = lo + 2 * i;
+      if (v >= BASE_LIMIT)
+        break;
+      if ((sieve_bits[i >> 5] & (1u << (i & 31))) == 0)
+        base_primes[n++] = v;
+    }
+    base_count = n;
+  }
+}
+
+void prime_iter_init(int start)
+{
+  unsigned first;
+
+  if (base_count == 0)
+    build_base_primes();
+
+  if (start < 2) {
+    pending_two = 1;
+    first = 3;
+  } else {
+    pending_two = 0;
+    first = ((unsigned) start + 1) | 1;
+  }
+  sieve_window(first);
+}
+
+int prime_iter_next(void)
+{
+  if (pending_two) {
+    pending_two = 0;
+    return 2;
+  }
+
+  for (;;) {
+    unsigned w = next_bit >> 5;
+
+    if (w < SIEVE_WORDS) {
+      /* Unmarked bits at or after next_bit in the current word. */
+      unsigned unmarked = ~sieve_bits[w] & (~0u << (next_bit & 31));
+
+      if (unmarked != 0) {
+        unsigned i = (w << 5) + lowest_bit(unmarked);
+        next_bit = i + 1;
+        return (int) (window_lo + 2 * i);
+      }
+      next_bit = (w + 1) << 5;
+    } else {
+      sieve_window(window_lo + 2 * SIEVE_BITS);
+    }
+  }
+}
@@ -0,0 +1,34 @@
+/* startup.h
+
+   Boot timing. _start in boot.S reads mcycle as its first
+   instruction and again right before it calls main, after clearing
+   .bss and setting up the trap vector; the difference is the cost of
+   getting from reset to C. Each lab calls startup_clock_started()
+   once its clock timer runs, which gives reset to clock: the number
+   that says how long the board sits dark after a reset. Bench builds
+   (DELAY_BENCH, PRIME_BENCH, ...) run their benches before that.
+
+   The boot banner is no longer printed by _start through an ecall.
+   Build with CPPFLAGS=-DBOOT_BANNER to have main print it, together
+   with the boot times, on the buffered console. */
+
+#ifndef STARTUP_H
+#define STARTUP_H
+
+extern unsigned long long boot_reset_cycles;
+extern unsigned long long boot_main_cycles;
+
+/* Cycles from reset to main. */
+unsigned startup_cycles(void);
+
+/* Record the first call: the clock is running. */
+void startup_clock_started(void);
+
+/* Cycles from reset to startup_clock_started(), 0 before it. */
+unsigned startup_clock_cycles(void);
+
+/* Print the banner and the boot times, and wait for the UART to take
+   them: some labs print nothing else and never drain the console. */
+void startup_banner(void);
+
+#endif
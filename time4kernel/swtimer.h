@@ -0,0 +1,51 @@
+/* swtimer.h
+
+   Software timers on a hierarchical timing wheel.
+
+   Any number of one-shot or periodic timers share one hardware tick.
+   Arming and cancelling are O(1); each tick touches one wheel slot,
+   plus an occasional cascade of a higher level down one step. Timers
+   live in caller storage, so there is no allocation.
+
+   Feed ticks with swtimer_advance(), usually from the timer interrupt,
+   and run the expired callbacks with swtimer_run(), either right after
+   it in the interrupt or later from the main loop. */
+
+#ifndef SWTIMER_H
+#define SWTIMER_H
+
+struct swtimer;
+typedef void (*swtimer_fn)(struct swtimer *t, void *arg);
+
+struct swtimer {
+  struct swtimer *next;
+  struct swtimer **pprev;               /* Null when not armed. */
+  unsigned expires;                     /* Absolute tick. */
+  unsigned period;                      /* 0 for one-shot. */
+  swtimer_fn fn;
+  void *arg;
+};
+
+void swtimer_init(struct swtimer *t, swtimer_fn fn, void *arg);
+
+/* Fire after ticks (at least one), then every period ticks if period
+   is nonzero. Re-arming an armed timer moves it. */
+void swtimer_arm(struct swtimer *t, unsigned ticks, unsigned period);
+void swtimer_cancel(struct swtimer *t);
+
+static inline int swtimer_armed(const struct swtimer *t)
+{
+  return t->pprev != 0;
+}
+
+/* Count one tick. Safe from an interrupt handler. */
+void swtimer_advance(void);
+
+/* Run every callback that is due. Callbacks run in the caller's
+   context and may arm or cancel any timer, including their own. */
+void swtimer_run(void);
+
+/* Ticks run so far. */
+unsigned swtimer_now(void);
+
+#endif
@@ -0,0 +1,152 @@
+/* sync.h
+
+   Sharing data between the main loop and interrupt handlers on the
+   one hart. There is no A extension and no second core, so nothing
+   here needs an atomic instruction or a fence: a handler runs to
+   completion before the code it interrupted goes on, and an aligned
+   word is loaded or stored in one access.
+
+   Critical sections clear mstatus.MIE and put it back as it was, so
+   they nest:
+
+     unsigned flags = irq_save();       CRITICAL_BEGIN();
+     ...                        or      ...
+     irq_restore(flags);                CRITICAL_END();
+
+   Single words need no lock, only one access the compiler cannot
+   split, merge or move: READ_ONCE/WRITE_ONCE, and publish()/consume()
+   when the word announces other data (an index, a count, a flag).
+
+   Multi-word state goes under a sequence lock. The writer makes seq
+   odd, updates, and makes it even again; a reader copies the state
+   and copies it again if seq was odd or moved meanwhile. Readers never
+   touch MIE, so they add nothing to interrupt latency; a main-loop
+   read is repeated at most once per interrupt that lands inside it.
+
+     static struct seqlock clock_lock;
+
+     SEQ_WRITE(&clock_lock, seconds = 0; minutes++);      in the handler
+     SEQ_READ(&clock_lock, m = minutes; s = seconds);     anywhere
+
+   Writers must not be interrupted by a reader of the same lock, or
+   the reader would spin on an odd seq forever. An interrupt handler
+   writes as it is; anything else writes inside a critical section,
+   which SEQ_WRITE_IRQ adds. */
+
+#ifndef SYNC_H
+#define SYNC_H
+
+/* Keeps the compiler from moving memory accesses across it. */
+#define barrier()  __asm__ volatile ("" ::: "memory")
+
+#ifdef DTEKV_HOST
+
+#include "dtekv-host.h"
+
+static inline unsigned irq_save(void)
+{
+  unsigned mstatus = host_mstatus;
+  host_mstatus &= ~8u;
+  barrier();
+  return mstatus;
+}
+
+static inline void irq_restore(unsigned mstatus)
+{
+  barrier();
+  host_mstatus |= mstatus & 8;
+}
+
+#else
+
+/* Clear MIE; returns the old mstatus for irq_restore(). */
+static inline unsigned irq_save(void)
+{
+  unsigned mstatus;
+  __asm__ volatile ("csrrci %0, mstatus, 8" : "=r"(mstatus) :: "memory");
+  return mstatus;
+}
+
+/* Set MIE again if it was set at the matching irq_save(). */
+static inline void irq_restore(unsigned mstatus)
+{
+  __asm__ volatile ("csrs mstatus, %0" :: "r"(mstatus & 8) : "memory");
+}
+
+#endif
+
+#define CRITICAL_BEGIN()  do { unsigned critical_flags_ = irq_save()
+#define CRITICAL_END()    irq_restore(critical_flags_); } while (0)
+
+#define READ_ONCE(x)      (*(volatile __typeof__(x) *) &(x))
+#define WRITE_ONCE(x, v)  (*(volatile __typeof__(x) *) &(x) = (v))
+
+/* Store v after everything written before it. */
+static inline void publish(volatile unsigned *p, unsigned v)
+{
+  barrier();
+  *p = v;
+}
+
+/* Load *p before everything read after it. */
+static inline unsigned consume(const volatile unsigned *p)
+{
+  unsigned v = *p;
+  barrier();
+  return v;
+}
+
+struct seqlock {
+  volatile unsigned seq;                /* Odd while a write is on. */
+};
+
+static inline void seq_write_begin(struct seqlock *l)
+{
+  l->seq++;
+  barrier();
+}
+
+static inline void seq_write_end(struct seqlock *l)
+{
+  barrier();
+  l->seq++;
+}
+
+static inline unsigned seq_read_begin(const struct seqlock *l)
+{
+  unsigned seq = l->seq;
+  barrier();
+  return seq;
+}
+
+/* Nonzero if what was read since seq_read_begin() may be torn. */
+static inline int seq_read_retry(const struct seqlock *l, unsigned seq)
+{
+  barrier();
+  return (seq & 1) | (l->seq != seq);
+}
+
+#define SEQ_WRITE(l, ...)                                       \
+  do {                                                          \
+    seq_write_begin(l);                                         \
+    __VA_ARGS__;                                                \
+    seq_write_end(l);                                           \
+  } while (0)
+
+#define SEQ_WRITE_IRQ(l, ...)                                   \
+  do {                                                          \
+    unsigned seq_flags_ = irq_save();                           \
+    SEQ_WRITE(l, __VA_ARGS__);                                  \
+    irq_restore(seq_flags_);                                    \
+  } while (0)
+
+#define SEQ_READ(l, ...)                                        \
+  do {                                                          \
+    unsigned seq_;                                              \
+    do {                                                        \
+      seq_ = seq_read_begin(l);                                 \
+      __VA_ARGS__;                                              \
+    } while (seq_read_retry(l, seq_));                          \
+  } while (0)
+
+#endif
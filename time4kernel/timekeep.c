@@ -0,0 +1,119 @@
+/* timekeep.c
+
+   base is the mcycle value of the last timeout accounted for. On an
+   update, reload - snapshot is how far the counter has run into the
+   current period, so now - phase is the latest timeout; its distance
+   from base, rounded to whole periods, is the number of periods that
+   ended. The usual case of exactly one skips the divide. */
+
+#include "timekeep.h"
+#include "dtekv-csr.h"
+#include "dtekv-hw.h"
+#include "sync.h"
+
+#define DAY 86400u
+
+static unsigned period;
+static unsigned ticks_per_second;
+static unsigned chunk;                  /* Periods in 2^29..2^30 cycles. */
+static unsigned long long base;
+static unsigned long long ticks;
+static struct seqlock ticks_lock;       /* Two words, read from anywhere. */
+static unsigned subticks;               /* ticks % ticks_per_second */
+static volatile unsigned secs;          /* ticks / ticks_per_second */
+static unsigned offset;                 /* Wall clock minus secs, mod DAY. */
+static unsigned lost;
+
+void timekeep_start(unsigned period_cycles, unsigned control)
+{
+  period = period_cycles;
+  ticks_per_second = TIMEKEEP_HZ / period_cycles;
+  chunk = 0x40000000u / period_cycles;
+  hw_timer_start(period_cycles - 1, TIMER_CONT | control);
+  base = read_mcycle();
+}
+
+unsigned timekeep_update(void)
+{
+  unsigned long long e;
+  unsigned phase, n = 0;
+
+  if (!hw_timer_timeout())
+    return 0;
+  hw_timer_ack();
+  phase = (period - 1) - hw_timer_snapshot();
+  e = read_mcycle() - phase - base;
+
+  /* Gaps past 2^31 cycles (71 s) only happen with the core halted;
+     bring them into 32-bit range a chunk of at most 2^30 cycles at a
+     time, so e cannot wrap and an hour takes some 200 steps. */
+  while (e > 0x7fffffffu) {
+    e -= (unsigned long long) chunk * period;
+    n += chunk;
+  }
+  if ((unsigned) e < period + period / 2)
+    n += 1;
+  else
+    n += ((unsigned) e + period / 2) / period;
+  if (n == 0)
+    return 0;
+
+  base += (unsigned long long) n * period;
+  SEQ_WRITE_IRQ(&ticks_lock, ticks += n);
+  lost += n - 1;
+  subticks += n;
+  if (subticks >= ticks_per_second) {
+    secs += subticks / ticks_per_second;
+    subticks %= ticks_per_second;
+  }
+  return n;
+}
+
+unsigned long long timekeep_ticks(void)
+{
+  unsigned long long t;
+
+  SEQ_READ(&ticks_lock, t = ticks);
+  return t;
+}
+
+unsigned timekeep_seconds(void)
+{
+  return secs;
+}
+
+unsigned timekeep_lost(void)
+{
+  return lost;
+}
+
+static unsigned wall(void)
+{
+  return (secs % DAY + offset) % DAY;
+}
+
+void timekeep_hms(int *hours, int *minutes, int *seconds)
+{
+  unsigned t = wall();
+  unsigned h = t / 3600, m = (t - h * 3600) / 60;
+
+  *hours = h;
+  *minutes = m;
+  *seconds = t - h * 3600 - m * 60;
+}
+
+unsigned timekeep_bcd(void)
+{
+  int h, m, s;
+
+  timekeep_hms(&h, &m, &s);
+  return (h / 10) << 20 | (h % 10) << 16 | (m / 10) << 12 |
+         (m % 10) << 8 | (s / 10) << 4 | (s % 10);
+}
+
+void timekeep_set_hms(int hours, int minutes, int seconds)
+{
+  unsigned want = (hours * 3600 + minutes * 60 + seconds) % DAY;
+
+  offset = (want + DAY - secs % DAY) % DAY;
+}
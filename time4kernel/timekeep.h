@@ -0,0 +1,40 @@
+/* timekeep.h
+
+   One monotonic clock for the whole program.
+
+   The interval timer runs continuously and timekeep_update() accounts
+   for every period that ended since the last call, not just one. The
+   count of elapsed periods comes from mcycle, phase-locked to the
+   hardware counter through the snapshot registers, so a main loop
+   that is late by several periods loses no time; it catches up in one
+   step and the periods it never saw are counted in timekeep_lost().
+
+   The wall clock (HH:MM:SS, or BCD for time2string) is derived from
+   the count when asked for. Setting it only moves an offset; the
+   monotonic count never jumps.
+
+   Assumes the timer and the core share the 30 MHz clock. */
+
+#ifndef TIMEKEEP_H
+#define TIMEKEEP_H
+
+#define TIMEKEEP_HZ 30000000u
+
+/* Start the timer with a period that divides TIMEKEEP_HZ evenly.
+   control may add TIMER_ITO to get an interrupt per period. */
+void timekeep_start(unsigned period_cycles, unsigned control);
+
+/* Call on a timeout (from the timer ISR or a polling loop). Acks the
+   timer and returns the number of periods accounted, 0 if none. */
+unsigned timekeep_update(void);
+
+unsigned long long timekeep_ticks(void);
+unsigned timekeep_seconds(void);        /* Monotonic, since start. */
+unsigned timekeep_lost(void);           /* Periods caught up on. */
+
+/* Wall clock views. */
+void timekeep_hms(int *hours, int *minutes, int *seconds);
+unsigned timekeep_bcd(void);            /* 0xHHMMSS */
+void timekeep_set_hms(int hours, int minutes, int seconds);
+
+#endif
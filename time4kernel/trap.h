@@ -0,0 +1,61 @@
+/* trap.h
+
+   Per-cause trap dispatch for the vectored entry in boot.S.
+
+   Interrupt n calls irq_table[n](n); exception n calls exc_table[n]
+   with the handle_exception() arguments. Every slot starts out at
+   handle_interrupt() / handle_exception(), so a lab that registers
+   nothing behaves as before. */
+
+#ifndef TRAP_H
+#define TRAP_H
+
+/* DTEK-V interrupt lines (mcause without the interrupt bit). */
+#define IRQ_TIMER   16
+#define IRQ_SWITCH  17
+#define IRQ_BUTTON  18
+
+#define EXC_ECALL   11                  /* Never reaches exc_table; see syscall.h */
+
+typedef void (*irq_handler_t)(unsigned cause);
+typedef void (*exc_handler_t)(unsigned arg0, unsigned arg1, unsigned arg2,
+                              unsigned arg3, unsigned arg4, unsigned arg5,
+                              unsigned mcause, unsigned syscall_num);
+
+extern irq_handler_t irq_table[32];
+extern exc_handler_t exc_table[16];
+
+/* Install fn for a cause; a null fn restores the default. */
+void irq_register(unsigned cause, irq_handler_t fn);
+void exc_register(unsigned cause, exc_handler_t fn);
+
+/* Enable or disable one interrupt line in mie. */
+#ifdef DTEKV_HOST
+
+#include "dtekv-host.h"
+
+static inline void irq_enable(unsigned cause)
+{
+  host_mie |= 1u << cause;
+}
+
+static inline void irq_disable(unsigned cause)
+{
+  host_mie &= ~(1u << cause);
+}
+
+#else
+
+static inline void irq_enable(unsigned cause)
+{
+  __asm__ volatile ("csrs mie, %0" :: "r"(1u << cause));
+}
+
+static inline void irq_disable(unsigned cause)
+{
+  __asm__ volatile ("csrc mie, %0" :: "r"(1u << cause));
+}
+
+#endif
+
+#endif
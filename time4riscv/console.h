@@ -0,0 +1,45 @@
+/* console.h
+
+   Buffered, non-blocking output on the JTAG UART.
+
+   Bytes are queued in a TX ring buffer and drained in bursts as large
+   as the free space the UART reports in the upper 16 bits of its
+   control register. Draining happens opportunistically on every
+   write, from console_poll(), and from console_irq() when the JTAG
+   UART write interrupt is wired up. */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#define CONSOLE_BUF_SIZE 1024           /* Must be a power of two. */
+
+/* What console_write() does when the ring buffer is full. */
+#define CONSOLE_DROP      0             /* Discard the new bytes. */
+#define CONSOLE_BLOCK     1             /* Spin until the UART drains. */
+#define CONSOLE_OVERWRITE 2             /* Discard the oldest queued bytes. */
+
+void console_set_policy(int policy);   /* Default: CONSOLE_BLOCK. */
+
+/* Queue len bytes and return at once. Returns the number of bytes
+   accepted, which is less than len only under CONSOLE_DROP. */
+int console_write(const char *buf, int len);
+void console_putc(char c);
+
+/* Move as many queued bytes to the UART as it has room for. */
+void console_poll(void);
+
+/* Drain everything, waiting on the UART as needed. */
+void console_flush(void);
+
+/* Drain from the JTAG UART write interrupt; an irq_handler_t, so
+   irq_register(line, console_irq) installs it. console_use_irq(1)
+   turns the interrupt on while bytes are pending. The DTEK-V does not
+   document a line for it, so a lab picks one at build time (suprise:
+   CPPFLAGS=-DCONSOLE_IRQ=n, dtekv-sim --jtag-irq n). */
+void console_irq(unsigned cause);
+void console_use_irq(int on);
+
+/* Bytes lost to CONSOLE_DROP or CONSOLE_OVERWRITE since boot. */
+unsigned console_dropped(void);
+
+#endif
@@ -0,0 +1,139 @@
+/* heap.c */
+
+#include "heap.h"
+#include "console.h"
+#include "fmt.h"
+#include "sync.h"
+
+extern char __heap_start[], __heap_end[];
+
+static char *heap_next = __heap_start;
+static struct arena *arenas;
+static struct pool *pools;
+
+static inline unsigned round_up(unsigned n)
+{
+  return (n + HEAP_ALIGN - 1) & ~(HEAP_ALIGN - 1u);
+}
+
+void *heap_carve(unsigned size)
+{
+  unsigned flags = irq_save();
+  char *p = heap_next;
+
+  /* Compare before rounding too, or a size near 4 GB wraps to 0. */
+  if (size > (unsigned) (__heap_end - p)
+      || (size = round_up(size)) > (unsigned) (__heap_end - p))
+    p = 0;
+  else
+    heap_next = p + size;
+  irq_restore(flags);
+  return p;
+}
+
+unsigned heap_used(void)
+{
+  return heap_next - __heap_start;
+}
+
+unsigned heap_size(void)
+{
+  return __heap_end - __heap_start;
+}
+
+int arena_init(struct arena *a, const char *name, unsigned size)
+{
+  a->base = heap_carve(size);
+  if (a->base == 0)
+    return -1;
+  a->name = name;
+  a->cur = a->base;
+  a->end = a->base + round_up(size);
+  a->high = 0;
+  a->next = arenas;
+  arenas = a;
+  return 0;
+}
+
+void *arena_alloc(struct arena *a, unsigned size)
+{
+  char *p = a->cur;
+  unsigned in_use;
+
+  if (size > (unsigned) (a->end - p)
+      || (size = round_up(size)) > (unsigned) (a->end - p))
+    return 0;
+  a->cur = p + size;
+  in_use = a->cur - a->base;
+  if (in_use > a->high)
+    a->high = in_use;
+  return p;
+}
+
+int pool_init(struct pool *p, const char *name, unsigned block, unsigned count)
+{
+  char *mem;
+  unsigned i;
+
+  /* block * count must neither wrap nor outgrow what is left. */
+  if (count == 0 || block > heap_size())
+    return -1;
+  block = round_up(block < sizeof(void *) ? sizeof(void *) : block);
+  if (block > (heap_size() - heap_used()) / count)
+    return -1;
+  mem = heap_carve(block * count);
+  if (mem == 0)
+    return -1;
+  p->name = name;
+  p->block = block;
+  p->count = count;
+  p->used = p->high = 0;
+  p->free = 0;
+  for (i = count; i-- > 0; ) {
+    *(void **) (mem + i * block) = p->free;
+    p->free = mem + i * block;
+  }
+  p->next = pools;
+  pools = p;
+  return 0;
+}
+
+void *pool_alloc(struct pool *p)
+{
+  unsigned flags = irq_save();
+  void *b = p->free;
+
+  if (b != 0) {
+    p->free = *(void **) b;
+    if (++p->used > p->high)
+      p->high = p->used;
+  }
+  irq_restore(flags);
+  return b;
+}
+
+void pool_free(struct pool *p, void *block)
+{
+  unsigned flags = irq_save();
+
+  *(void **) block = p->free;
+  p->free = block;
+  p->used--;
+  irq_restore(flags);
+}
+
+void heap_dump(void)
+{
+  char line[96];
+  struct arena *a;
+  struct pool *p;
+
+  console_write(line, fmt(line, "HEAP used=%u size=%u\n",
+                          heap_used(), heap_size()));
+  for (a = arenas; a != 0; a = a->next)
+    console_write(line, fmt(line, "ARENA %s size=%u high=%u\n", a->name,
+                            (unsigned) (a->end - a->base), a->high));
+  for (p = pools; p != 0; p = p->next)
+    console_write(line, fmt(line, "POOL %s block=%u count=%u used=%u high=%u\n",
+                            p->name, p->block, p->count, p->used, p->high));
+}
@@ -0,0 +1,148 @@
+/* input.c
+
+   The first edge of a change is taken at once, so a press costs no
+   debounce latency; edges after it within the window are ignored.
+   If the line settled on the other level during the window there is
+   no edge left to report it, so the bit is marked unsettled and
+   input_read() samples it again once the window has passed.
+
+   The PIO captures rising edges only, so a release or a switch going
+   down raises no interrupt. input_read() therefore also samples every
+   source with a bit up; that is one PIO read per call, and it reports
+   the fall once the bit's debounce window has passed. */
+
+#include "input.h"
+#include "dtekv-csr.h"
+#include "dtekv-hw.h"
+#include "sync.h"
+#include "trap.h"
+
+#define QUEUE_MASK (INPUT_QUEUE_SIZE - 1)
+
+struct source {
+  struct dtekv_pio *pio;
+  unsigned mask;
+  unsigned char id;
+  unsigned stable;                      /* Debounced level. */
+  unsigned unsettled;                   /* Bits to sample again. */
+  unsigned last[16];                    /* Time of the last accepted change. */
+};
+
+static struct source buttons = { HW_BUTTONS, INPUT_BUTTON_MASK, INPUT_BUTTONS };
+static struct source switches = { HW_SWITCHES, INPUT_SWITCH_MASK, INPUT_SWITCHES };
+
+static struct input_event queue[INPUT_QUEUE_SIZE];
+static volatile unsigned q_head;        /* Written by the producer only. */
+static volatile unsigned q_tail;        /* Written by the consumer only. */
+static unsigned dropped;
+
+/* Producer side. Always runs with MIE clear. */
+static void push(struct source *s, int bit, unsigned time)
+{
+  unsigned head = q_head;
+  struct input_event *ev;
+
+  if (head - q_tail == INPUT_QUEUE_SIZE) {
+    dropped++;
+    return;
+  }
+  ev = &queue[head & QUEUE_MASK];
+  ev->time = time;
+  ev->state = s->stable;
+  ev->source = s->id;
+  ev->bit = bit;
+  publish(&q_head, head + 1);           /* Event before head. */
+}
+
+static void sample(struct source *s, unsigned time)
+{
+  unsigned diff = (HW_READ(s->pio->data) & s->mask) ^ s->stable;
+  int bit;
+
+  s->unsettled = 0;
+  for (bit = 0; diff != 0; bit++, diff >>= 1) {
+    if (!(diff & 1))
+      continue;
+    if (time - s->last[bit] >= INPUT_DEBOUNCE_CYCLES) {
+      s->stable ^= 1u << bit;
+      s->last[bit] = time;
+      push(s, bit, time);
+    } else {
+      s->unsettled |= 1u << bit;
+    }
+  }
+}
+
+static void input_irq(unsigned cause)
+{
+  struct source *s = cause == IRQ_SWITCH ? &switches : &buttons;
+
+  /* Ack first: an edge while sampling raises the line again. */
+  HW_WRITE(s->pio->edge_capture, 0);
+  sample(s, (unsigned) read_mcycle());
+}
+
+static void source_init(struct source *s, unsigned time)
+{
+  int i;
+
+  s->stable = HW_READ(s->pio->data) & s->mask;
+  for (i = 0; i < 16; i++)
+    s->last[i] = time - INPUT_DEBOUNCE_CYCLES;
+  HW_WRITE(s->pio->edge_capture, 0);
+  HW_WRITE(s->pio->irq_mask, s->mask);
+}
+
+void input_init(void)
+{
+  unsigned flags = irq_save();
+  unsigned time = (unsigned) read_mcycle();
+
+  source_init(&buttons, time);
+  source_init(&switches, time);
+  irq_register(IRQ_BUTTON, input_irq);
+  irq_register(IRQ_SWITCH, input_irq);
+  irq_enable(IRQ_BUTTON);
+  irq_enable(IRQ_SWITCH);
+  irq_restore(flags);
+}
+
+int input_read(struct input_event *ev, int max)
+{
+  unsigned tail = q_tail;
+  unsigned head;
+  int n = 0;
+
+  /* Bits that are up can only be seen falling by sampling them. */
+  if (buttons.unsettled | buttons.stable |
+      switches.unsettled | switches.stable) {
+    unsigned flags = irq_save();
+    unsigned time = (unsigned) read_mcycle();
+    if (buttons.unsettled | buttons.stable)
+      sample(&buttons, time);
+    if (switches.unsettled | switches.stable)
+      sample(&switches, time);
+    irq_restore(flags);
+  }
+
+  head = consume(&q_head);              /* Head before events. */
+  while (tail != head && n < max)
+    ev[n++] = queue[tail++ & QUEUE_MASK];
+  publish(&q_tail, tail);               /* Events before tail. */
+  return n;
+}
+
+unsigned input_buttons(void)
+{
+  return buttons.stable;
+}
+
+unsigned input_switches(void)
+{
+  return switches.stable;
+}
+
+unsigned input_dropped(void)
+{
+  return dropped;
+}
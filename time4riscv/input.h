@@ -0,0 +1,47 @@
+/* input.h
+
+   Debounced, interrupt-driven button and switch events.
+
+   input_init() turns on the edge interrupts of the button and switch
+   PIOs. The handler timestamps each edge, drops bounces that come
+   within INPUT_DEBOUNCE_CYCLES of the last accepted change of the
+   same input, and queues one event per accepted change. The main loop
+   drains the queue with input_read(). The PIOs capture rising edges
+   only, so input_read() also reads the level of any source with a bit
+   up: that is how releases and switches going down are seen.
+
+   The queue is a single-producer, single-consumer ring: the handler
+   only moves the head and input_read() only moves the tail, so
+   neither side needs a lock. */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#define INPUT_QUEUE_SIZE      64        /* Power of two. */
+#define INPUT_DEBOUNCE_CYCLES 150000    /* 5 ms at 30 MHz */
+
+#define INPUT_BUTTON_MASK     0x1
+#define INPUT_SWITCH_MASK     0x3FF
+
+enum { INPUT_BUTTONS, INPUT_SWITCHES };
+
+struct input_event {
+  unsigned time;                        /* mcycle (low word) of the edge. */
+  unsigned short state;                 /* Debounced level of the source. */
+  unsigned char source;                 /* INPUT_BUTTONS or INPUT_SWITCHES */
+  unsigned char bit;                    /* The input that changed. */
+};
+
+void input_init(void);
+
+/* Copy up to max queued events to ev; returns how many. */
+int input_read(struct input_event *ev, int max);
+
+/* Debounced levels as of the last accepted event. */
+unsigned input_buttons(void);
+unsigned input_switches(void);
+
+/* Events lost to a full queue. */
+unsigned input_dropped(void);
+
+#endif
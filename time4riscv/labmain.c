@@ -1,4 +1,12 @@
 #include <stdio.h>
+#include "clock.h"
+#include "delay.h"
+#include "display.h"
+#include "dtekv-hw.h"
+#include "startup.h"
+#include "input.h"
+#include "swtimer.h"
+#include "timekeep.h"
 
 /* main.c
 
@@ -18,63 +26,43 @@ extern int nextprime(int);
 int mytime = 0x5957;
 char textstring[] = "text, more text, and even more text!";
 
+// One software-timer tick per millisecond (30,000 cycles at 30 MHz)
+#define TICK_CYCLES 30000
+
 /* Below is the function that will be called when an interrupt is triggered. */
 void handle_interrupt(unsigned cause) {}
 
 /* Add your code here for initializing interrupts. */
-void labinit(void) {}
+void labinit(void) {
+    // 1 ms continuous period; polled, so no interrupt (ITO) needed
+    timekeep_start(TICK_CYCLES, 0);
+
+    // Button and switch edges arrive as queued events (input.c)
+    input_init();
+    __asm__ volatile ("csrsi mstatus, 8");
+    startup_clock_started();
+}
 
 void set_leds(int led_mask) {
-    volatile int* led_ptr = (volatile int*)0x04000000;
-
     /*
      * Only the first 10 bits affect the LEDs, but we write the whole int.
      */
-    *led_ptr = led_mask;
+    hw_leds(led_mask);
 }
 
 void set_displays(int display_number, int value) {
-    // Lookup table for 7-segment decoding (Active Low)
-    // 0 = Segment ON, 1 = Segment OFF
-    // Mapping bit0=A, bit1=B, ... bit6=G
-
-    static const int hex_codes[] = {
-        0xC0,  // 0: 1100 0000 (A,B,C,D,E,F on)
-        0xF9,  // 1: 1111 1001 (B,C on)
-        0xA4,  // 2: 1010 0100 (A,B,D,E,G on)
-        0xB0,  // 3: 1011 0000 (A,B,C,D,G on)
-        0x99,  // 4: 1001 1001 (B,C,F,G on)
-        0x92,  // 5: 1001 0010 (A,C,D,F,G on)
-        0x82,  // 6: 1000 0010 (A,C,D,E,F,G on)
-        0xF8,  // 7: 1111 1000 (A,B,C on)
-        0x80,  // 8: 1000 0000 (All on)
-        0x90   // 9: 1001 0000 (A,B,C,D,F,G on)
-    };
-
-    // Calculate the specific address for the requested display
-    volatile int* display_ptr = (volatile int*)(0x04000050 + (display_number * 0x10));
-
-    // Write the decoded value if it is a valid digit
-    if (value >= 0 && value <= 9) {
-        *display_ptr = hex_codes[value];
-    } else {
-        // Turn off all segments if value is invalid (0xFF = 1111 1111)
-        *display_ptr = 0xFF;
-    }
+    // Digits 0-9 are decoded (active low); anything else blanks the display
+    display_digit(display_number, value);
+    display_flush();
 }
 
 int get_sw(void) {
-    volatile int* sw_ptr = (volatile int*)0x04000010;
-
-    int sw_value = *sw_ptr;
-
-    // Mask the result to return only the 10 least significant bits
-    // 0x3FF is 11 1111 1111 in binary
-    return sw_value & 0x3FF;
+    // Only the 10 least significant bits are switches
+    return hw_switches();
 }
 
 int get_btn(void) {
-    return *(volatile int*)0x040000d0 & 1;
+    return hw_buttons() & 1;
 }
 
 void assignment_1_d() {
@@ -93,9 +81,8 @@ void assignment_1_d() {
 
         count++;
 
-        // Approximate 1 second delay
-        volatile int delay_counter;
-        for (delay_counter = 0; delay_counter < 1000000; delay_counter++);
+        // 1 second delay
+        delay_ms(1000);
     }
 }
 
@@ -114,85 +101,68 @@ void test_toggles() {
     }
 }
 
+/* The time itself lives in timekeep; only the display needs a timer. */
+static struct swtimer display_timer;  // every 20 ms: refresh the displays
+
+// Set the time from the switches while the button is held
+static void apply_switches(void) {
+    int hours, minutes, seconds;
+
+    if (input_buttons() & 1) {
+        // Switches 9:8 pick seconds, minutes or hours; 5:0 the value
+        timekeep_hms(&hours, &minutes, &seconds);
+        clock_set_from_switches(&hours, &minutes, &seconds, input_switches());
+        timekeep_set_hms(hours, minutes, seconds);
+    }
+}
+
+// Drain the input queue; only edges cost anything
+static void handle_input(void) {
+    struct input_event ev[8];
+    int i, n, changed;
+
+    while ((n = input_read(ev, 8)) > 0) {
+        changed = 0;
+        for (i = 0; i < n; i++)
+            changed |= ev[i].source == INPUT_SWITCHES || ev[i].bit == 0;
+        if (changed)
+            apply_switches();
+    }
+}
+
+static void display_expired(struct swtimer* t, void* arg) {
+    int hours, minutes, seconds;
+
+    timekeep_hms(&hours, &minutes, &seconds);
+
+    // Only the digits that changed reach the hardware
+    display_clock(hours, minutes, seconds);
+    display_flush();
+}
+
 /* Your code goes into main as well as any needed functions. */
 int main() {
+
     // Call labinit()
     labinit();
+#ifdef BOOT_BANNER
+    startup_banner();
+#endif
 
-    int hours = 0;
-    int minutes = 0;
-    int seconds = 0;
-    int ms_tick;
-    int current_btn;
-    int sw_val;
-    int selector;
-    int value;
-    volatile int delay;
+    swtimer_init(&display_timer, display_expired, 0);
+    swtimer_arm(&display_timer, 20, 20);
 
     /*
-     * Infinite Loop: Digital Clock Logic
+     * Infinite Loop: the hardware timer is polled once per pass and
+     * each elapsed period is one software-timer tick, including the
+     * ones a slow pass missed.
      */
     while (1) {
-        // We simulate 1 second by looping 1000 times with a small delay.
-        for (ms_tick = 0; ms_tick < 1000; ms_tick++) {
-            // Get current button state
-            current_btn = get_btn();
-
-            // 1. Check Button & Update Time CONSTANTLY
-            // it returns 1 when pressed.
-            if (current_btn != 0) {
-                sw_val = get_sw();
-
-                // Extract Selector (Bits 9 and 8)
-                // 01 (1) = Seconds, 10 (2) = Minutes, 11 (3) = Hours
-                selector = (sw_val >> 8) & 0x03;
-
-                // Extract Value (Bits 0-5)
-                value = sw_val & 0x3F;
-
-                if (selector == 1) {  // Set Seconds
-                    if (value < 60)
-                        seconds = value;
-                    else
-                        seconds = 59;
-                } else if (selector == 2) {  // Set Minutes
-                    if (value < 60)
-                        minutes = value;
-                    else
-                        minutes = 59;
-                } else if (selector == 3) {  // Set Hours
-                    if (value < 24)
-                        hours = value;
-                    else
-                        hours = 23;
-                }
-            }
-
-            // 2. Refresh Displays continuously
-            set_displays(0, seconds % 10);
-            set_displays(1, seconds / 10);
-            set_displays(2, minutes % 10);
-            set_displays(3, minutes / 10);
-            set_displays(4, hours % 10);
-            set_displays(5, hours / 10);
-
-            // 3. Small Delay (approx 1ms)
-            for (delay = 0; delay < 1000; delay++);
-        }
-
-        // 4. Increment the time (After approx 1 second)
-        seconds++;
-        if (seconds >= 60) {
-            seconds = 0;
-            minutes++;
-            if (minutes >= 60) {
-                minutes = 0;
-                hours++;
-                if (hours >= 24) {
-                    hours = 0;
-                }
-            }
-        }
+        unsigned n = timekeep_update();
+        while (n--)
+            swtimer_advance();
+        swtimer_run();
+        handle_input();
     }
 
     return 0;
@@ -0,0 +1,167 @@
+/* swtimer.c
+
+   Five wheel levels cover the full 32-bit tick range: level 0 has
+   256 slots of one tick, levels 1-4 have 64 slots each, every slot
+   spanning 64 times the one below. A timer goes into the lowest level
+   whose range covers its delay. When level 0 wraps, the next slot of
+   level 1 is emptied and its timers re-added, which puts them in
+   level 0; the same happens one level up whenever that slot index
+   wraps too.
+
+   now is the next tick to run. pending counts ticks advanced but not
+   yet run; list updates and the pending count are done with MIE
+   cleared, callbacks are not. */
+
+#include "swtimer.h"
+#include "sync.h"
+
+#define ROOT_BITS   8
+#define LEVEL_BITS  6
+#define ROOT_SIZE   (1 << ROOT_BITS)
+#define LEVEL_SIZE  (1 << LEVEL_BITS)
+#define ROOT_MASK   (ROOT_SIZE - 1)
+#define LEVEL_MASK  (LEVEL_SIZE - 1)
+#define LEVELS      4                   /* Above the root. */
+
+static struct swtimer *root[ROOT_SIZE];
+static struct swtimer *level[LEVELS][LEVEL_SIZE];
+static unsigned now;
+static volatile unsigned pending;
+static int running;
+
+static void link(struct swtimer **head, struct swtimer *t)
+{
+  t->next = *head;
+  if (t->next)
+    t->next->pprev = &t->next;
+  t->pprev = head;
+  *head = t;
+}
+
+static void unlink(struct swtimer *t)
+{
+  if (t->next)
+    t->next->pprev = t->pprev;
+  *t->pprev = t->next;
+  t->pprev = 0;
+}
+
+/* Put t in the slot that covers its expiry. */
+static void add(struct swtimer *t)
+{
+  unsigned e = t->expires;
+  unsigned delta = e - now;
+  int shift, i;
+
+  if ((int) delta < 0) {                /* Already due: run next tick. */
+    link(&root[now & ROOT_MASK], t);
+    return;
+  }
+  if (delta < ROOT_SIZE) {
+    link(&root[e & ROOT_MASK], t);
+    return;
+  }
+  for (i = 0, shift = ROOT_BITS; i < LEVELS - 1; i++, shift += LEVEL_BITS)
+    if (delta < 1u << (shift + LEVEL_BITS))
+      break;
+  link(&level[i][(e >> shift) & LEVEL_MASK], t);
+}
+
+/* Re-add the timers of one slot; returns the slot index. */
+static unsigned cascade(int i)
+{
+  unsigned idx = (now >> (ROOT_BITS + i * LEVEL_BITS)) & LEVEL_MASK;
+  struct swtimer *t = level[i][idx];
+
+  level[i][idx] = 0;
+  while (t) {
+    struct swtimer *next = t->next;
+    add(t);
+    t = next;
+  }
+  return idx;
+}
+
+void swtimer_init(struct swtimer *t, swtimer_fn fn, void *arg)
+{
+  t->next = 0;
+  t->pprev = 0;
+  t->period = 0;
+  t->fn = fn;
+  t->arg = arg;
+}
+
+void swtimer_arm(struct swtimer *t, unsigned ticks, unsigned period)
+{
+  unsigned flags = irq_save();
+
+  if (t->pprev)
+    unlink(t);
+  t->expires = now + (ticks ? ticks - 1 : 0);
+  t->period = period;
+  add(t);
+  irq_restore(flags);
+}
+
+void swtimer_cancel(struct swtimer *t)
+{
+  unsigned flags = irq_save();
+
+  if (t->pprev)
+    unlink(t);
+  irq_restore(flags);
+}
+
+void swtimer_advance(void)
+{
+  unsigned flags = irq_save();
+  pending++;
+  irq_restore(flags);
+}
+
+unsigned swtimer_now(void)
+{
+  return now;
+}
+
+void swtimer_run(void)
+{
+  unsigned flags = irq_save();
+
+  if (running) {                        /* The outer call will see it. */
+    irq_restore(flags);
+    return;
+  }
+  running = 1;
+
+  while (pending) {
+    struct swtimer *work, *t;
+    unsigned idx = now & ROOT_MASK;
+    int i;
+
+    pending--;
+    for (i = 0; idx == 0 && i < LEVELS; i++)
+      idx = cascade(i);
+
+    /* Detach the slot first so callbacks can re-arm into it. */
+    work = root[now & ROOT_MASK];
+    root[now & ROOT_MASK] = 0;
+    if (work)
+      work->pprev = &work;
+    now++;
+
+    while ((t = work) != 0) {
+      unlink(t);
+      if (t->period) {
+        t->expires += t->period;
+        add(t);
+      }
+      irq_restore(flags);
+      t->fn(t, t->arg);
+      flags = irq_save();
+    }
+  }
+
+  running = 0;
+  irq_restore(flags);
+}
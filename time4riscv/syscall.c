@@ -0,0 +1,51 @@
+/* syscall.c
+
+   The default system calls. Output goes straight to the buffered
+   console, so a string costs its length and nothing per character
+   beyond the copy into the ring. */
+
+#include "syscall.h"
+#include "console.h"
+#include "dtekv-csr.h"
+#include "dtekv-lib.h"
+
+static unsigned long long sys_nosys(unsigned a0, unsigned a1, unsigned a2)
+{
+  return 0xFFFFFFFFu;
+}
+
+static unsigned long long sys_print(unsigned a0, unsigned a1, unsigned a2)
+{
+  print((char *) a0);
+  return 0;
+}
+
+static unsigned long long sys_putc(unsigned a0, unsigned a1, unsigned a2)
+{
+  printc(a0);
+  return 0;
+}
+
+static unsigned long long sys_write(unsigned a0, unsigned a1, unsigned a2)
+{
+  return (unsigned) console_write((const char *) a0, a1);
+}
+
+static unsigned long long sys_cycles(unsigned a0, unsigned a1, unsigned a2)
+{
+  return read_mcycle();
+}
+
+syscall_fn syscall_table[SYS_MAX] = {
+  [0 ... SYS_MAX - 1] = sys_nosys,
+  [SYS_PRINT] = sys_print,
+  [SYS_PUTC] = sys_putc,
+  [SYS_WRITE] = sys_write,
+  [SYS_CYCLES] = sys_cycles,
+};
+
+void syscall_register(unsigned num, syscall_fn fn)
+{
+  if (num < SYS_MAX)
+    syscall_table[num] = fn ? fn : sys_nosys;
+}
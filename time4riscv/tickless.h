@@ -0,0 +1,40 @@
+/* tickless.h
+
+   Tickless timekeeping on the interval timer.
+
+   Instead of a fixed 10 Hz tick the timer runs one-shot and is always
+   programmed for the next real deadline: the next second boundary or
+   the earliest pending software timeout, whichever comes first. Time
+   is kept in mcycle, so reprogramming latency never accumulates as
+   drift, and a late interrupt runs every second it missed.
+
+   Callbacks run from the timer interrupt. The idle path should call
+   tickless_idle() (wfi) rather than spin. Only timer4timer has an idle
+   path; time4int and suprise search for primes the whole time, so
+   there the mode just takes nine timer interrupts a second away.
+   They apply the ten 100 ms ticks of mytime together, once a second,
+   so mytime counts as in the periodic build. */
+
+#ifndef TICKLESS_H
+#define TICKLESS_H
+
+#define TICKLESS_HZ       30000000u     /* mcycle rate on the DTEK-V. */
+#define TICKLESS_TIMEOUTS 4
+
+typedef void (*tickless_fn)(void);
+
+/* Take over the timer interrupt; call on_second once per second. */
+void tickless_start(tickless_fn on_second);
+
+/* Call fn once, cycles from now. Returns a slot, or -1 if all are busy. */
+int tickless_after(unsigned cycles, tickless_fn fn);
+
+/* Drop a pending timeout. */
+void tickless_cancel(int slot);
+
+static inline void tickless_idle(void)
+{
+  __asm__ volatile ("wfi");
+}
+
+#endif
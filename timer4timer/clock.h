@@ -0,0 +1,27 @@
+/* clock.h
+
+   The clock arithmetic of the labs, without any hardware access, so
+   the same code also builds and runs on the host (see host/).
+
+   clock_tick() and clock_time2string() are C twins of tick and
+   time2string in timetemplate.S, with the same arguments and results;
+   the labs keep calling the assembly versions. */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+/* Advance by n >= 0 seconds, wrapping at 24:00:00. */
+void clock_add_seconds(int *hours, int *minutes, int *seconds, int n);
+
+/* Set one field from the switches: bits 9:8 pick seconds (1),
+   minutes (2) or hours (3), bits 5:0 are the value, clamped. */
+void clock_set_from_switches(int *hours, int *minutes, int *seconds,
+                             unsigned switches);
+
+/* BCD mm:ss in the low 16 bits; a carry out of 59:59 lands in bit 16. */
+void clock_tick(int *t);
+
+/* "MM:SS" and a '\0' from the low 16 bits of t: six bytes. */
+void clock_time2string(char *buf, int t);
+
+#endif
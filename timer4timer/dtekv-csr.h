@@ -0,0 +1,55 @@
+/* dtekv-csr.h
+
+   Helpers for reading the machine performance counters on the
+   DTEK-V board (rv32imzicsr).
+
+   On RV32 the 64-bit counters are split into a low and a high CSR.
+   The high half is read twice so that a carry out of the low half
+   between the two reads is never returned as a torn value.
+
+   With -DDTEKV_HOST both count host time instead (host/dtekv-host.h). */
+
+#ifndef DTEKV_CSR_H
+#define DTEKV_CSR_H
+
+#ifdef DTEKV_HOST
+
+#include "dtekv-host.h"
+
+static inline unsigned long long read_mcycle(void)
+{
+  return host_cycles();
+}
+
+static inline unsigned long long read_minstret(void)
+{
+  return host_cycles();
+}
+
+#else
+
+static inline unsigned long long read_mcycle(void)
+{
+  unsigned hi, lo, hi2;
+  do {
+    __asm__ volatile ("csrr %0, mcycleh" : "=r"(hi));
+    __asm__ volatile ("csrr %0, mcycle"  : "=r"(lo));
+    __asm__ volatile ("csrr %0, mcycleh" : "=r"(hi2));
+  } while (hi != hi2);
+  return ((unsigned long long) hi << 32) | lo;
+}
+
+static inline unsigned long long read_minstret(void)
+{
+  unsigned hi, lo, hi2;
+  do {
+    __asm__ volatile ("csrr %0, minstreth" : "=r"(hi));
+    __asm__ volatile ("csrr %0, minstret"  : "=r"(lo));
+    __asm__ volatile ("csrr %0, minstreth" : "=r"(hi2));
+  } while (hi != hi2);
+  return ((unsigned long long) hi << 32) | lo;
+}
+
+#endif
+
+#endif
@@ -1,9 +1,11 @@
 void printc(char );
 void print(char *);
 void print_dec(unsigned int);
+void print_dec64(unsigned long long);
 void print_hex32 ( unsigned int);
 void handle_exception ( unsigned arg0, unsigned arg1, unsigned arg2, unsigned arg3, unsigned arg4, unsigned arg5, unsigned mcause, unsigned syscall_num );
 int nextprime( int inval );
+void bench_nextprime(void);
 
 
 
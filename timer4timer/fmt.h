@@ -0,0 +1,17 @@
+/* fmt.h
+
+   Integer formatting into caller buffers, without libc and without
+   the divider. Every function writes a terminating '\0' and returns
+   the number of characters written, not counting the '\0'. */
+
+#ifndef FMT_H
+#define FMT_H
+
+int fmt_udec(char *buf, unsigned x);     /* At most 10 characters. */
+int fmt_dec(char *buf, int x);           /* At most 11 characters. */
+int fmt_hex32(char *buf, unsigned x);    /* Always 8 characters. */
+
+/* Minimal printf: %u, %d, %x (8 hex digits), %s, %c and %%. */
+int fmt(char *buf, const char *f, ...);
+
+#endif
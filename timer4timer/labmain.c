@@ -1,4 +1,10 @@
 #include <stdio.h>
+#include "clock.h"
+#include "delay.h"
+#include "display.h"
+#include "dtekv-hw.h"
+#include "startup.h"
+#include "timekeep.h"
 
 /* main.c
 
@@ -18,76 +24,47 @@ extern int nextprime(int);
 int mytime = 0x5957;
 char textstring[] = "text, more text, and even more text!";
 
-int timeoutcount = 0;
+// Build with CPPFLAGS=-DTICKLESS: the timer fires once a second and the
+// loop sleeps in wfi between events. mstatus.MIE stays clear, so wfi
+// wakes on the mie lines below without ever taking a trap.
 
 /* Below is the function that will be called when an interrupt is triggered. */
 void handle_interrupt(unsigned cause) {}
 
 /* Add your code here for initializing interrupts. */
 void labinit(void) {
-    volatile int* timer_periodl = (volatile int*)(0x04000020 + 0x8);
-    volatile int* timer_periodh = (volatile int*)(0x04000020 + 0xC);
-    volatile int* timer_control = (volatile int*)(0x04000020 + 0x4);
-    volatile int* timer_status = (volatile int*)(0x04000020);
-
-    // 3,000,000 in hex is 0x2DC6C0
-    // Write Period registers
-    *timer_periodl = 0xC6C0;  // Lower 16 bits
-    *timer_periodh = 0x002D;  // Upper 16 bits
-
-    // Start Timer with Continuous mode
-    // Bit 1: CONT, Bit 2: START. Value = 0110 binary = 0x6
-    *timer_control = 0x6;
-    *timer_status = 0;
+#ifdef TICKLESS
+    // 30,000,000 cycles = 1 s; ITO raises the line that wakes wfi
+    timekeep_start(30000000, TIMER_ITO);
+
+    // A button press wakes the loop too
+    HW_WRITE(HW_BUTTONS->irq_mask, 1);
+    HW_WRITE(HW_BUTTONS->edge_capture, 0);
+    __asm__ volatile ("csrw mie, %0" :: "r"((1 << 16) | (1 << 18)));
+#else
+    // 3,000,000 cycles = 100 ms, continuous mode
+    timekeep_start(3000000, 0);
+#endif
+    startup_clock_started();
 }
 
 void set_leds(int led_mask) {
-    volatile int* led_ptr = (volatile int*)0x04000000;
-
-    *led_ptr = led_mask;
+    hw_leds(led_mask);
 }
 
 void set_displays(int display_number, int value) {
-    // Lookup table for 7-segment decoding
-    // 0 = Segment ON, 1 = Segment OFF
-    // Mapping assumed: bit0=A, bit1=B, ... bit6=G
-    static const int hex_codes[] = {
-        0xC0,  // 0: 1100 0000 (A,B,C,D,E,F on)
-        0xF9,  // 1: 1111 1001 (B,C on)
-        0xA4,  // 2: 1010 0100 (A,B,D,E,G on)
-        0xB0,  // 3: 1011 0000 (A,B,C,D,G on)
-        0x99,  // 4: 1001 1001 (B,C,F,G on)
-        0x92,  // 5: 1001 0010 (A,C,D,F,G on)
-        0x82,  // 6: 1000 0010 (A,C,D,E,F,G on)
-        0xF8,  // 7: 1111 1000 (A,B,C on)
-        0x80,  // 8: 1000 0000 (All on)
-        0x90   // 9: 1001 0000 (A,B,C,D,F,G on)
-    };
-
-    // Calculate the specific address for the requested display
-    volatile int* display_ptr = (volatile int*)(0x04000050 + (display_number * 0x10));
-
-    // Write the decoded value if it is a valid digit
-    if (value >= 0 && value <= 9) {
-        *display_ptr = hex_codes[value];
-    } else {
-        // Turn off all segments if value is invalid (0xFF = 1111 1111)
-        *display_ptr = 0xFF;
-    }
+    // Digits 0-9 are decoded (active low); anything else blanks the display
+    display_digit(display_number, value);
+    display_flush();
 }
 
 int get_sw(void) {
-    volatile int* sw_ptr = (volatile int*)0x04000010;
-
-    int sw_value = *sw_ptr;
-
-    // Mask the result to return only the 10 least significant bits
-    // 0x3FF is 11 1111 1111 in binary
-    return sw_value & 0x3FF;
+    // Only the 10 least significant bits are switches
+    return hw_switches();
 }
 
 int get_btn(void) {
-    return *(volatile int*)0x040000d0 & 1;
+    return hw_buttons() & 1;
 }
 
 void assignment_1_d() {
@@ -106,9 +83,8 @@ void assignment_1_d() {
 
         count++;
 
-        // Approximate 1 second delay
-        volatile int delay_counter;
-        for (delay_counter = 0; delay_counter < 1000000; delay_counter++);
+        // 1 second delay
+        delay_ms(1000);
     }
 }
 
@@ -128,86 +104,54 @@ void test_toggles() {
 }
 
 int main() {
-    int hours = 0;
-    int minutes = 0;
-    int seconds = 0;
+    int hours;
+    int minutes;
+    int seconds;
     int current_btn;
-    int sw_val;
-    int selector;
-    int value;
-    int mytime = 0;       // Time variable for the assembly functions
+    int mytime;           // Time variable for the assembly functions
+    unsigned shown = 0;   // Last second put on the displays
     char textbuffer[30];  // Buffer for time2string
 
-    // Pointers for Timer registers
-    volatile int* timer_status = (volatile int*)(0x04000020);
-
     labinit();
+#ifdef BOOT_BANNER
+    startup_banner();
+#endif
 
     /*
      * Infinite Loop: Digital Clock Logic
      */
     while (1) {
+#ifdef TICKLESS
+        // Sleep until the next second or a button press
+        __asm__ volatile ("wfi");
+        HW_WRITE(HW_BUTTONS->edge_capture, 0);
+#endif
         // 1. Check Button & Switches CONSTANTLY (Every loop iteration)
         current_btn = get_btn();
 
         if (current_btn != 0) {
-            sw_val = get_sw();
-
-            // Extract Selector (Bits 9 and 8)
-            selector = (sw_val >> 8) & 0x03;
-            // Extract Value (Bits 0-5)
-            value = sw_val & 0x3F;
-
-            if (selector == 1) {  // Set Seconds
-                seconds = (value < 60) ? value : 59;
-            } else if (selector == 2) {  // Set Minutes
-                minutes = (value < 60) ? value : 59;
-            } else if (selector == 3) {  // Set Hours
-                hours = (value < 24) ? value : 23;
-            }
+            // Switches 9:8 pick seconds, minutes or hours; 5:0 the value
+            timekeep_hms(&hours, &minutes, &seconds);
+            clock_set_from_switches(&hours, &minutes, &seconds, get_sw());
+            timekeep_set_hms(hours, minutes, seconds);
         }
 
         // 2. Check Timer Timeout (Polling)
-        // Bit 0 of Status register is 1 if timeout occurred
-        if ((*timer_status & 1) == 1) {
-            // Reset the timeout flag (Write 0 to Status)
-            *timer_status = 0;
-
-            // Increment the global counter
-            timeoutcount++;
-
-            // Only update displays and time once every 10 timeouts (1 Second)
-            if (timeoutcount >= 10) {
-                timeoutcount = 0;
-
-                // --- Assembly Function Calls ---
-                tick(&mytime);
-                time2string(textbuffer, mytime);
-                display_string(textbuffer);
-
-                // --- 7-Segment Clock Logic ---
-                // Increment time logic
-                seconds++;
-                if (seconds >= 60) {
-                    seconds = 0;
-                    minutes++;
-                    if (minutes >= 60) {
-                        minutes = 0;
-                        hours++;
-                        if (hours >= 24) {
-                            hours = 0;
-                        }
-                    }
-                }
-
-                // Update the display registers
-                set_displays(0, seconds % 10);
-                set_displays(1, seconds / 10);
-                set_displays(2, minutes % 10);
-                set_displays(3, minutes / 10);
-                set_displays(4, hours % 10);
-                set_displays(5, hours / 10);
-            }
+        // timekeep counts every period since the last pass, so a slow
+        // iteration delays the display but never loses time
+        timekeep_update();
+        if (timekeep_seconds() != shown) {
+            shown = timekeep_seconds();
+
+            // --- Assembly Function Calls ---
+            mytime = timekeep_bcd() & 0xFFFF;  // MM:SS
+            time2string(textbuffer, mytime);
+            display_string(textbuffer);
+
+            // --- 7-Segment Clock Logic ---
+            timekeep_hms(&hours, &minutes, &seconds);
+            display_clock(hours, minutes, seconds);
+            display_flush();
         }
     }
 